@@ -13,12 +13,29 @@
 #pragma once
 
 #include <time.h>
+#include <klib/ktimezone.h>
 
 BEGIN_DECLS
 
+/** Format a time in the specified zone. fmt is a strftime() format, or
+ * one of the special formats "24hr" (HH:MM), "24hr_secs" (HH:MM:SS), 
+ * or "short_date" (e.g., "Mar  7"). The caller must free the result. */
 extern char *datetimeconv_format_time (const char *fmt, const char *tz_city, 
          time_t t);
 
+/** As datetimeconv_format_time, but with a zone object rather than a 
+ * zone name. This saves looking up the zone on every call. As with
+ * all the _in_zone functions, a NULL zone means the local zone of the 
+ * process. */
+extern char *datetimeconv_format_time_in_zone (const char *fmt, 
+         const KTimeZone *zone, time_t t);
+
+/** As datetimeconv_format_time_in_zone, but writes into the caller's 
+ * buffer rather than allocating a string. The result is truncated if 
+ * the buffer is too small. Returns the length of the result. */
+extern int datetimeconv_format_time_in_zone_buff (const char *fmt, 
+         const KTimeZone *zone, time_t t, char *buff, size_t size);
+
 /** Get the day of the year in which falls the specified time. For the
     avoidance of doubt: t relates to a UTC time. */
 extern int    datetimeconv_get_day_of_year (time_t t);
@@ -38,10 +55,16 @@ time_t datetimeconv_jd_to_time (double jd);
 extern time_t datetimeconv_maketime (int year, int month, int day, 
                 int hour, int min, int sec, const char *tz);
 
+extern time_t datetimeconv_maketime_in_zone (int year, int month, int day, 
+                int hour, int min, int sec, const KTimeZone *zone);
+
 /** Change the time of a time_t, whilst keeping the date the same. */
 extern time_t datetimeconv_make_time_on_day (time_t t, int h, 
                 int m, int s, const char *tz);
 
+extern time_t datetimeconv_make_time_on_day_in_zone (time_t t, int h, 
+                int m, int s, const KTimeZone *zone);
+
 /** Parse a date in a variety of different formats. The h and m arguments
  * are the hours and minutes to fill in, to complete the time_t return
  * value. Supported formats are:
@@ -0,0 +1,61 @@
+/*============================================================================
+  
+  klib
+  
+  kasynclog.h
+
+  An asynchronous handler for klog
+
+  When it is started, this module installs itself as the klog handler.
+  Each thread that logs gets a ring buffer of its own, into which 
+  messages are copied without taking any lock; a background thread 
+  collects them from all the rings and writes them to stderr in 
+  batches. So a thread that logs never waits for I/O, or for another 
+  thread. If a thread logs faster than the output can keep up, so that
+  its ring fills, further messages are dropped and counted, rather than
+  blocking the thread or using more memory. 
+
+  Messages longer than KASYNCLOG_MAX_LINE bytes, including the level 
+  and class, are truncated.
+
+  Copyright (c)1990-2020 Kevin Boone. Distributed under the terms of the
+  GNU Public Licence, v3.0
+
+  ==========================================================================*/
+#pragma once
+
+#include <stdint.h>
+#include <klib/types.h>
+#include <klib/defs.h>
+#include <klib/klog.h>
+
+#define KASYNCLOG_MAX_LINE 256 
+
+/** Default number of messages each thread's ring can hold. */
+#define KASYNCLOG_DEFAULT_RING_SIZE 64 
+
+BEGIN_DECLS
+
+/** Start the background thread, and install the handler. ring_size is
+    the number of messages each thread can have waiting to be written;
+    it is rounded up to a power of two. A value of zero selects the 
+    default. Returns FALSE if the thread could not be started, in which
+    case logging carries on as before. */
+extern BOOL     kasynclog_start (int ring_size);
+
+/** Remove the handler, write any messages that are waiting, and stop
+    the background thread. */
+extern void     kasynclog_stop (void);
+
+/** Get the number of messages that have been dropped because a ring 
+    was full. */
+extern uint64_t kasynclog_get_dropped (void);
+
+/** The handler itself. There should be no need to call this directly,
+    or to install it with klog_set_handler(); kasynclog_start() does 
+    that. */
+extern void     kasynclog_handler (KLogLevel level, const char *cls, 
+                  void *user_data, const char *msg);
+
+END_DECLS
+
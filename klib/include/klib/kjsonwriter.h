@@ -0,0 +1,103 @@
+/*============================================================================
+  
+  klib
+  
+  kjsonwriter.h
+
+  Definition of the KJsonWriter class
+
+  A KJsonWriter builds a JSON document as UTF-8 bytes, in a single 
+  buffer that grows geometrically -- or in storage supplied by the 
+  caller, until that runs out. It keeps track of nesting, and inserts 
+  the separators between values, so the caller only has to say what 
+  the values are. Unlike building JSON in a KString, nothing is 
+  converted to and from UTF-32, and a typical document needs at most
+  one or two allocations.
+
+  Copyright (c)1990-2020 Kevin Boone. Distributed under the terms of the
+  GNU Public Licence, v3.0
+
+  ==========================================================================*/
+#pragma once
+
+#include <stddef.h>
+#include <klib/types.h>
+#include <klib/defs.h>
+
+/** Maximum depth of nested objects and arrays. */
+#define KJSONWRITER_MAX_DEPTH 16
+
+/** Flags for objects and arrays. */
+// Separate the members with ",\n" rather than ","
+#define KJSONWRITER_NEWLINES 0x0001
+
+struct _KJsonWriter;
+typedef struct _KJsonWriter KJsonWriter;
+
+BEGIN_DECLS
+
+/** Create a writer with its own, initially empty, buffer. */
+extern KJsonWriter *kjsonwriter_new (void);
+
+/** Create a writer that uses the caller's storage, of the specified
+    size, for as long as the document fits. If it does not, the
+    writer moves it to a buffer of its own. The caller's storage must
+    outlive the writer. */
+extern KJsonWriter *kjsonwriter_new_with_buffer (char *buff, size_t size);
+
+extern void         kjsonwriter_destroy (KJsonWriter *self);
+
+/** Discard the document, but keep the buffer, so the writer can be 
+    used again. */
+extern void         kjsonwriter_reset (KJsonWriter *self);
+
+/** Start an object or an array. If this is a member of an object, 
+    the key must have been written first. */
+extern void         kjsonwriter_begin_object (KJsonWriter *self, int flags);
+extern void         kjsonwriter_end_object (KJsonWriter *self);
+extern void         kjsonwriter_begin_array (KJsonWriter *self, int flags);
+extern void         kjsonwriter_end_array (KJsonWriter *self);
+
+/** Write the key of an object member. The value must follow. */
+extern void         kjsonwriter_key (KJsonWriter *self, const char *key);
+
+/** Write a string value, escaped as necessary. A NULL string is 
+    written as null. */
+extern void         kjsonwriter_string (KJsonWriter *self, const char *s);
+
+/** Write a number in printf's %g format. */
+extern void         kjsonwriter_number (KJsonWriter *self, double n);
+
+extern void         kjsonwriter_int (KJsonWriter *self, int64_t n);
+
+extern void         kjsonwriter_bool (KJsonWriter *self, BOOL b);
+
+extern void         kjsonwriter_null (KJsonWriter *self);
+
+/** Write a value that is already JSON -- an object, for example, that
+    was written by another writer. It is written as it is, but with a 
+    separator, as for any other value. */
+extern void         kjsonwriter_json (KJsonWriter *self, const char *json, 
+                      size_t len);
+
+/** Write a line break. This has no meaning in JSON, but makes the 
+    document easier to read. */
+extern void         kjsonwriter_newline (KJsonWriter *self);
+
+/** Write text directly into the document, with no escaping or 
+    separators. */
+extern void         kjsonwriter_raw (KJsonWriter *self, const char *s, 
+                      size_t len);
+
+/** Get the document. It is nul-terminated, and remains valid until
+    the writer is next written to, reset, or destroyed. */
+extern const char  *kjsonwriter_get_data (const KJsonWriter *self);
+
+extern size_t       kjsonwriter_get_length (const KJsonWriter *self);
+
+/** Get the document as a string that the caller must free. The 
+    writer is left empty. */
+extern char        *kjsonwriter_to_utf8 (KJsonWriter *self);
+
+END_DECLS
+
@@ -15,7 +15,9 @@
 #include <klib/types.h>
 #include <klib/defs.h>
 #include <klib/klog.h>
+#include <klib/kasynclog.h>
 #include <klib/kbuffer.h>
+#include <klib/kjsonwriter.h>
 #include <klib/kstring.h>
 #include <klib/kpath.h>
 #include <klib/klist.h>
@@ -25,6 +27,7 @@
 #include <klib/kterminal.h>
 #include <klib/klinux_terminal.h>
 #include <klib/numberformat.h>
+#include <klib/ktimezone.h>
 #include <klib/datetimeconv.h>
 #include <klib/mathutil.h>
 
@@ -24,8 +24,20 @@ typedef enum
   KLOG_TRACE = 4
   } KLogLevel;
 
+// Function entry and exit tracing. Building with KLOG_TRACE_ENABLED=0
+//  removes it entirely, along with its cost, which is not negligible
+//  in small functions even when the log level is below trace
+#ifndef KLOG_TRACE_ENABLED
+#define KLOG_TRACE_ENABLED 1
+#endif
+
+#if KLOG_TRACE_ENABLED
 #define KLOG_IN klog_trace(KLOG_CLASS, "Entering %s ", __PRETTY_FUNCTION__);
 #define KLOG_OUT klog_trace(KLOG_CLASS, "Leaving %s", __PRETTY_FUNCTION__);
+#else
+#define KLOG_IN
+#define KLOG_OUT
+#endif
 
 BEGIN_DECLS
 
@@ -45,6 +45,7 @@ extern const UTF32  *kstring_cstr (const KString *self);
     etc. To be able to use this in number base conversion, 'a' and 'A' -> 10,
     and so on. This function will not work with non-ASCII characters. */
 extern int           kstring_char_to_number (char c);
+/** Empty the string. The storage is kept for reuse. */
 extern void          kstring_clear (KString *self);
 
 extern void          kstring_delete (KString *self, int start, int count);
@@ -90,6 +91,12 @@ extern KString      *kstring_substring (const KString *self, int start,
 extern BOOL          kstring_to_integer (const KString *self, int *value, 
                        int radix);
 
+/** Make sure the string has room for at least capacity characters
+    (not including the terminator), so that appending up to that length
+    does not need to allocate. Short strings are stored in the KString
+    object itself, and need no separate storage at all. */
+extern void          kstring_reserve (KString *self, size_t capacity);
+
 extern UTF8         *kstring_to_utf8 (const KString *self);
 
 /** Remove whitspace from the start of a string. */
@@ -0,0 +1,77 @@
+/*============================================================================
+
+  klib
+
+  ktimezone.h
+
+  Definition of the KTimeZone class
+
+  A KTimeZone is a compiled, immutable representation of a timezone from
+  the system timezone database (TZif files, usually in
+  /usr/share/zoneinfo). It converts between UTC and local time without
+  touching the process environment, so it is safe to use from many
+  threads at once -- unlike the traditional approach of setting TZ and
+  calling tzset().
+
+  Copyright (c)1990-2020 Kevin Boone. Distributed under the terms of the
+  GNU Public Licence, v3.0
+
+  ==========================================================================*/
+#pragma once
+
+#include <time.h>
+#include <klib/types.h>
+#include <klib/defs.h>
+
+struct _KTimeZone;
+typedef struct _KTimeZone KTimeZone;
+
+BEGIN_DECLS
+
+/** Get the zone with the specified name, e.g., "Europe/London". The
+    TZif file is parsed the first time a particular zone is asked for,
+    and its rules are compiled into a sorted table of offset transitions
+    covering the foreseeable future; subsequent calls return the same
+    object. The object belongs to
+    klib, and lasts for the lifetime of the program -- the caller must
+    not destroy it. Returns NULL if the zone can't be loaded. The zone
+    files are read from $TZDIR if it is set, or /usr/share/zoneinfo
+    otherwise. */
+extern const KTimeZone *ktimezone_get (const char *name);
+
+/** Get a zone that represents UTC. This never fails, and does not
+    require the timezone database to be installed. */
+extern const KTimeZone *ktimezone_get_utc (void);
+
+/** Load a zone from a TZif file. Most callers should use ktimezone_get(),
+    which shares zones between callers. Returns NULL if the file can't be
+    read or parsed. The caller should destroy the result. */
+extern KTimeZone *ktimezone_new_from_file (const char *name,
+                     const char *path);
+
+extern void       ktimezone_destroy (KTimeZone *self);
+
+extern const char *ktimezone_get_name (const KTimeZone *self);
+
+/** Get the offset, in seconds east of Greenwich, of local time from UTC
+    at the specified instant. */
+extern int        ktimezone_get_offset (const KTimeZone *self, time_t t);
+
+/** Convert a UTC time to a broken-down local time. This is the equivalent
+    of localtime_r() with TZ set to this zone. tm_zone, if the C library
+    supports it, points to storage in the zone object. Returns tm. */
+extern struct tm *ktimezone_utc_to_local (const KTimeZone *self, time_t t,
+                    struct tm *tm);
+
+/** Convert a broken-down local time to UTC. This is the equivalent of
+    mktime() with TZ set to this zone: out-of-range fields are normalized,
+    and the other fields of tm are filled in. If the local time is
+    ambiguous (at the end of daylight saving) tm_isdst selects which
+    one is meant; -1 selects the later. A local time that does not exist
+    (at the start of daylight saving) is interpreted using the offset
+    that was in effect before the change. */
+extern time_t     ktimezone_local_to_utc (const KTimeZone *self,
+                    struct tm *tm);
+
+END_DECLS
+
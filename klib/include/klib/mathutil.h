@@ -38,6 +38,17 @@ extern void mathutil_get_negative_axis_crossings (double *x, double *y,
 extern void mathutil_get_positive_axis_crossings (double *x, double *y, 
           int npoints, double *mins, int maxmins, int *nmins);
 
+/** Fit a parabola through three equally-spaced points, with y values
+ * y0, y1, and y2, and find where it crosses the x axis. The crossing is
+ * written to offset, in units of the point spacing, relative to the
+ * middle point. Returns FALSE if the parabola does not cross the axis.
+ * This is the step that the get_xxx_axis_crossings functions apply to
+ * each triple of points in which the sign changes; it is exposed so 
+ * that callers that generate their points one at a time do not have to
+ * store them all. */
+extern BOOL mathutil_interpolate_crossing (double y0, double y1, double y2,
+          double *offset);
+
 /** Constrain an angle in degrees to lie in the range 0-359.9... */
 extern double mathutil_fix_angle (double angle);
 
@@ -15,14 +15,76 @@
 #include <math.h>
 #include <time.h>
 #include <klib/klog.h> 
+#include <klib/ktimezone.h> 
 #include <klib/datetimeconv.h> 
 
 #define KLOG_CLASS "klib.datetimeconv"
 
-static char *getenv_dup (const char *env); //FWD
-static void my_setenv (const char *name, const char *value, BOOL dummy); // FWD
 extern char *strptime (const char *s, const char *fmt, struct tm *tm);
 
+/*==========================================================================
+
+  datetimeconv_resolve
+
+  Get the zone object for a zone name, or NULL for the zone of the
+  process if the name is NULL. Conversions used to be done by setting TZ
+  in the environment and calling tzset(), which was both slow and a data
+  race between threads. Now they are done by a KTimeZone object, and the
+  environment is never modified.
+
+==========================================================================*/
+static const KTimeZone *datetimeconv_resolve (const char *tz)
+  {
+  KLOG_IN
+  const KTimeZone *zone = NULL;
+  if (tz)
+    {
+    zone = ktimezone_get (tz);
+    // The C library treats an unknown TZ as UTC, and so do we
+    if (!zone) zone = ktimezone_get_utc ();
+    }
+  KLOG_OUT
+  return zone;
+  }
+
+/*==========================================================================
+
+  datetimeconv_localtime
+
+  Convert t to local time in the zone or, if zone is NULL, in the
+  zone of the process. 
+
+==========================================================================*/
+static void datetimeconv_localtime (const KTimeZone *zone, time_t t, 
+         struct tm *tm)
+  {
+  KLOG_IN
+  if (zone)
+    ktimezone_utc_to_local (zone, t, tm);
+  else
+    localtime_r (&t, tm);
+  KLOG_OUT
+  }
+
+/*==========================================================================
+
+  datetimeconv_mktime
+
+  The inverse of datetimeconv_localtime()
+
+==========================================================================*/
+static time_t datetimeconv_mktime (const KTimeZone *zone, struct tm *tm)
+  {
+  KLOG_IN
+  time_t ret;
+  if (zone)
+    ret = ktimezone_local_to_utc (zone, tm);
+  else
+    ret = mktime (tm);
+  KLOG_OUT
+  return ret;
+  }
+
 
 /*==========================================================================
 
@@ -33,40 +95,64 @@ char *datetimeconv_format_time (const char *fmt, const char *tz,
          time_t t)
   {
   KLOG_IN
-  char *oldtz = NULL;
-  if (tz)
-    {
-    oldtz = getenv_dup ("TZ");
-    my_setenv ("TZ", tz, 1);
-    tzset ();
-    }
+  char *ret = datetimeconv_format_time_in_zone (fmt, 
+    datetimeconv_resolve (tz), t);
+  KLOG_OUT
+  return ret;
+  }
+
+/*==========================================================================
+
+  datetimeconv_format_time_in_zone
 
+==========================================================================*/
+char *datetimeconv_format_time_in_zone (const char *fmt, 
+         const KTimeZone *zone, time_t t)
+  {
+  KLOG_IN
   char s[100]; 
+  datetimeconv_format_time_in_zone_buff (fmt, zone, t, s, sizeof (s));
+  KLOG_OUT
+  return strdup (s);
+  }
+
+/*==========================================================================
+
+  datetimeconv_format_time_in_zone_buff
+
+==========================================================================*/
+int datetimeconv_format_time_in_zone_buff (const char *fmt, 
+         const KTimeZone *zone, time_t t, char *buff, size_t size)
+  {
+  KLOG_IN
+  static const char *months[12] = 
+    {"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug",
+      "Sep", "Oct", "Nov", "Dec"};
+
+  int ret;
   struct tm tm;
-  localtime_r (&t, &tm);
+  datetimeconv_localtime (zone, t, &tm);
   if (strcmp (fmt, "24hr") == 0)
-    sprintf (s, "%02d:%02d", tm.tm_hour, tm.tm_min);
+    ret = snprintf (buff, size, "%02d:%02d", tm.tm_hour, tm.tm_min);
+  else if (strcmp (fmt, "24hr_secs") == 0)
+    ret = snprintf (buff, size, "%02d:%02d:%02d", tm.tm_hour, tm.tm_min,
+      tm.tm_sec);
   else if (strcmp (fmt, "short_date") == 0)
     {
-    ctime_r (&t, s);
-    memmove (s, s+4, 20);
-    s[6] = 0;
+    // Same layout as the month and day of ctime(), e.g., "Mar  7"
+    ret = snprintf (buff, size, "%s%3d", months[tm.tm_mon], tm.tm_mday);
     }
   else
-    strftime (s, sizeof (s), fmt, &tm);
-
-  if (tz)
     {
-    my_setenv ("TZ", oldtz, 1);
-    if (oldtz) free (oldtz);
-    tzset ();
+    ret = strftime (buff, size, fmt, &tm);
+    if (ret == 0 && size > 0) buff[0] = 0;
     }
+  if (ret >= (int)size) ret = size > 0 ? (int)size - 1 : 0;
 
   KLOG_OUT
-  return strdup (s);
+  return ret;
   }
 
-
 /*==========================================================================
 
   datetimeconv_get_day_of_year
@@ -76,7 +162,7 @@ int datetimeconv_get_day_of_year (time_t t)
   {
   KLOG_IN
   struct tm tm;
-  memcpy (&tm, gmtime (&t), sizeof (struct tm));
+  gmtime_r (&t, &tm);
   int ret = tm.tm_yday + 1;
   KLOG_OUT
   return ret;
@@ -105,17 +191,24 @@ time_t datetimeconv_maketime (int year, int month, int day,
          int hour, int min, int sec, const char *tz)
   {
   KLOG_IN
-  char *oldtz = NULL;
-  if (tz)
-    {
-    oldtz = getenv_dup ("TZ");
-    my_setenv ("TZ", tz, 1);
-    tzset ();
-    }
+  time_t ret = datetimeconv_maketime_in_zone (year, month, day, 
+    hour, min, sec, datetimeconv_resolve (tz));
+  KLOG_OUT
+  return ret;
+  }
 
+/*==========================================================================
+
+  datetimeconv_maketime_in_zone
+
+==========================================================================*/
+time_t datetimeconv_maketime_in_zone (int year, int month, int day, 
+         int hour, int min, int sec, const KTimeZone *zone)
+  {
+  KLOG_IN
   time_t now = time (NULL);
   struct tm tm;
-  localtime_r (&now, &tm);  
+  datetimeconv_localtime (zone, now, &tm);  
 
   if (sec >= 0) 
     tm.tm_sec = sec;
@@ -137,14 +230,7 @@ time_t datetimeconv_maketime (int year, int month, int day,
 
   tm.tm_isdst = -1; // Have the std library work it out
 
-  time_t ret = mktime (&tm); 
-
-  if (tz)
-    {
-    my_setenv ("TZ", oldtz, 1);
-    if (oldtz) free (oldtz);
-    tzset ();
-    }
+  time_t ret = datetimeconv_mktime (zone, &tm); 
 
   KLOG_OUT
   return ret;
@@ -159,16 +245,23 @@ time_t datetimeconv_make_time_on_day (time_t t, int h,
                 int m, int s, const char *tz)
   {
   KLOG_IN
-  char *oldtz = NULL;
-  if (tz)
-    {
-    oldtz = getenv_dup ("TZ");
-    my_setenv ("TZ", tz, 1);
-    tzset ();
-    }
+  time_t ret = datetimeconv_make_time_on_day_in_zone (t, h, m, s, 
+    datetimeconv_resolve (tz));
+  KLOG_OUT
+  return ret;
+  }
 
+/*==========================================================================
+
+  datetimeconv_make_time_on_day_in_zone
+
+==========================================================================*/
+time_t datetimeconv_make_time_on_day_in_zone (time_t t, int h, 
+                int m, int s, const KTimeZone *zone)
+  {
+  KLOG_IN
   struct tm tm;
-  localtime_r (&t, &tm);  
+  datetimeconv_localtime (zone, t, &tm);  
 
   if (s >= 0) 
     tm.tm_sec = s;
@@ -181,14 +274,7 @@ time_t datetimeconv_make_time_on_day (time_t t, int h,
 
   tm.tm_isdst = -1; // Have the std library work it out
 
-  time_t ret = mktime (&tm); 
-
-  if (tz)
-    {
-    my_setenv ("TZ", oldtz, 1);
-    if (oldtz) free (oldtz);
-    tzset ();
-    }
+  time_t ret = datetimeconv_mktime (zone, &tm); 
 
   KLOG_OUT
   return ret;
@@ -227,15 +313,10 @@ time_t datetimeconv_parse_date (const char *s, int h, int m,
   struct tm tm;
   time_t now = time(NULL);
 
-  char *oldtz = NULL;
-  if (tz)
-    {
-    oldtz = getenv_dup ("TZ");
-    my_setenv ("TZ", tz, 1);
-    tzset ();
-    }
+  const KTimeZone *zone = datetimeconv_resolve (tz);
 
-  localtime_r (&now, &tm); // We only want the year from this conversion
+  // We only want the year from this conversion
+  datetimeconv_localtime (zone, now, &tm); 
   tm.tm_hour = h;
   tm.tm_min = m;
   tm.tm_sec = 0;
@@ -250,14 +331,7 @@ time_t datetimeconv_parse_date (const char *s, int h, int m,
     {
     // Good for the next 30 years. I won't be worried by then ;)
     if (tm.tm_year < 50) tm.tm_year += 2000;
-    ret = mktime (&tm); 
-    }
-
-  if (tz)
-    {
-    my_setenv ("TZ", oldtz, 1);
-    if (oldtz) free (oldtz);
-    tzset ();
+    ret = datetimeconv_mktime (zone, &tm); 
     }
 
   KLOG_OUT
@@ -304,38 +378,3 @@ double datetimeconv_time_to_mjd (time_t t)
   }
 
 
-/*=======================================================================
-
-  getenv_dup
-
-  Gets a copy of an environment string. Caller must free it, if it is
-  not NULL
-
-=======================================================================*/
-static char *getenv_dup (const char *env)
-  {
-  KLOG_IN
-  char *s = getenv (env);
-  KLOG_OUT
-  if (s) return strdup (s);
-  return NULL;
-  }
-
-/*=======================================================================
-
-  my_setenv
-
-  A variant of setenv() that allows a NULL value to call unsetenv; 
-  setenv() itself does not accept NULL as a value
-
-=======================================================================*/
-static void my_setenv (const char *name, const char *value, BOOL dummy)
-  {
-  KLOG_IN
-  if (value)
-    setenv (name, value, 1);
-  else
-    unsetenv (name);
-  KLOG_OUT
-  }
-
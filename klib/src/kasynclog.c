@@ -0,0 +1,313 @@
+/*============================================================================
+  
+  klib
+  
+  kasynclog.c
+
+  Each logging thread owns a single-producer, single-consumer ring of 
+  fixed-size slots. The thread writes a slot, and then publishes it by
+  advancing the ring's head; the background thread reads slots up to
+  the head, and then frees them by advancing the tail. Neither needs a
+  lock. The only lock is on the list of rings, which a logging thread
+  takes only the first time it logs.
+
+  When a thread exits, its ring is marked as orphaned; the background
+  thread frees it once it has written out what is left in it.
+
+  Copyright (c)1990-2020 Kevin Boone. Distributed under the terms of the
+  GNU Public Licence, v3.0
+
+  ==========================================================================*/
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <pthread.h>
+#include <time.h>
+#include <klib/kasynclog.h>
+
+// Interval at which the background thread looks for messages
+#define DRAIN_INTERVAL_NS (10 * 1000 * 1000)
+
+// Size of the buffer in which messages are batched for output
+#define BATCH_SIZE 16384
+
+/*============================================================================
+  
+  KAsyncLogRing
+
+  ==========================================================================*/
+typedef struct _KAsyncLogRing
+  {
+  struct _KAsyncLogRing *next;
+  size_t mask;     // Number of slots, less one
+  size_t head;     // Next slot to write; written only by the owner
+  size_t tail;     // Next slot to read; written only by the drainer
+  BOOL orphaned;   // The owning thread has exited
+  char (*slots)[KASYNCLOG_MAX_LINE];
+  } KAsyncLogRing;
+
+static pthread_mutex_t rings_mutex = PTHREAD_MUTEX_INITIALIZER;
+static KAsyncLogRing *rings = NULL;
+static pthread_key_t ring_key;
+static pthread_once_t ring_key_once = PTHREAD_ONCE_INIT;
+static __thread KAsyncLogRing *my_ring = NULL;
+
+static size_t ring_size = KASYNCLOG_DEFAULT_RING_SIZE;
+static pthread_t drain_thread;
+static BOOL running = FALSE;
+static BOOL stop_requested = FALSE;
+static uint64_t dropped = 0;
+
+/*============================================================================
+  
+  kasynclog_orphan_ring
+
+  Called when a thread that has logged exits
+
+  ==========================================================================*/
+static void kasynclog_orphan_ring (void *p)
+  {
+  KAsyncLogRing *ring = p;
+  __atomic_store_n (&ring->orphaned, TRUE, __ATOMIC_RELEASE);
+  }
+
+/*============================================================================
+  
+  kasynclog_make_key
+
+  ==========================================================================*/
+static void kasynclog_make_key (void)
+  {
+  pthread_key_create (&ring_key, kasynclog_orphan_ring);
+  }
+
+/*============================================================================
+  
+  kasynclog_get_ring
+
+  Get the calling thread's ring, creating and registering it if this
+  is the first time the thread has logged
+
+  ==========================================================================*/
+static KAsyncLogRing *kasynclog_get_ring (void)
+  {
+  if (my_ring) return my_ring;
+  pthread_once (&ring_key_once, kasynclog_make_key);
+  KAsyncLogRing *ring = malloc (sizeof (KAsyncLogRing));
+  memset (ring, 0, sizeof (KAsyncLogRing));
+  ring->mask = ring_size - 1;
+  ring->slots = malloc (ring_size * KASYNCLOG_MAX_LINE);
+  pthread_setspecific (ring_key, ring);
+  pthread_mutex_lock (&rings_mutex);
+  ring->next = rings;
+  rings = ring;
+  pthread_mutex_unlock (&rings_mutex);
+  my_ring = ring;
+  return ring;
+  }
+
+/*============================================================================
+  
+  kasynclog_handler
+
+  ==========================================================================*/
+void kasynclog_handler (KLogLevel level, const char *cls, 
+       void *user_data, const char *msg)
+  {
+  KAsyncLogRing *ring = kasynclog_get_ring ();
+  size_t head = ring->head;
+  size_t tail = __atomic_load_n (&ring->tail, __ATOMIC_ACQUIRE);
+  if (head - tail > ring->mask)
+    {
+    __atomic_add_fetch (&dropped, 1, __ATOMIC_RELAXED);
+    return;
+    }
+  char *slot = ring->slots[head & ring->mask];
+  int n = snprintf (slot, KASYNCLOG_MAX_LINE, "%s %s: %s", 
+    klog_level_to_utf8 (level), cls, msg);
+  if (n >= KASYNCLOG_MAX_LINE) n = KASYNCLOG_MAX_LINE - 1;
+  // The newline replaces the terminator, or the last character if the
+  //  message was truncated; the drainer relies on finding it
+  if (n == KASYNCLOG_MAX_LINE - 1) n--;
+  slot[n] = '\n';
+  slot[n + 1] = 0;
+  __atomic_store_n (&ring->head, head + 1, __ATOMIC_RELEASE);
+  }
+
+/*============================================================================
+  
+  kasynclog_write
+
+  ==========================================================================*/
+static void kasynclog_write (const char *buff, size_t len)
+  {
+  while (len > 0)
+    {
+    ssize_t n = write (STDERR_FILENO, buff, len);
+    if (n <= 0) return;
+    buff += n;
+    len -= n;
+    }
+  }
+
+/*============================================================================
+  
+  kasynclog_drain
+
+  Write out everything that is waiting in all the rings, and free any
+  ring whose thread has exited and that is now empty. Messages are 
+  copied into a batch with rings_mutex held, but the batch is written
+  only after the mutex is released: a thread that logs for the first
+  time has to take the mutex to add its ring, and must not wait for
+  stderr. If the batch fills, it is written, and the rings are 
+  scanned again.
+
+  ==========================================================================*/
+static void kasynclog_drain (void)
+  {
+  static char batch[BATCH_SIZE];
+  BOOL full = TRUE;
+
+  while (full)
+    {
+    size_t len = 0;
+    full = FALSE;
+
+    pthread_mutex_lock (&rings_mutex);
+    KAsyncLogRing **prev = &rings;
+    KAsyncLogRing *ring = rings;
+    while (ring && !full)
+      {
+      // Read orphaned before head: if the thread has exited, the head 
+      //  we then read is final
+      BOOL orphaned = __atomic_load_n (&ring->orphaned, __ATOMIC_ACQUIRE);
+      size_t head = __atomic_load_n (&ring->head, __ATOMIC_ACQUIRE);
+      size_t tail = ring->tail;
+      while (tail != head)
+        {
+        const char *slot = ring->slots[tail & ring->mask];
+        size_t l = strlen (slot);
+        if (len + l > BATCH_SIZE)
+          {
+          full = TRUE;
+          break;
+          }
+        memcpy (batch + len, slot, l);
+        len += l;
+        tail++;
+        }
+      __atomic_store_n (&ring->tail, tail, __ATOMIC_RELEASE);
+
+      KAsyncLogRing *next = ring->next;
+      if (orphaned && tail == head)
+        {
+        *prev = next;
+        free (ring->slots);
+        free (ring);
+        }
+      else
+        prev = &ring->next;
+      ring = next;
+      }
+    pthread_mutex_unlock (&rings_mutex);
+
+    if (len) kasynclog_write (batch, len);
+    }
+  }
+
+/*============================================================================
+  
+  kasynclog_report_dropped
+
+  Write a warning if any messages have been dropped since the last one
+
+  ==========================================================================*/
+static void kasynclog_report_dropped (uint64_t *reported)
+  {
+  uint64_t d = __atomic_load_n (&dropped, __ATOMIC_RELAXED);
+  if (d != *reported)
+    {
+    char s[100];
+    int n = snprintf (s, sizeof (s), 
+      "WARN klib.kasynclog: %llu log messages dropped\n", 
+      (unsigned long long) (d - *reported));
+    kasynclog_write (s, n);
+    *reported = d;
+    }
+  }
+
+/*============================================================================
+  
+  kasynclog_thread
+
+  ==========================================================================*/
+static void *kasynclog_thread (void *arg)
+  {
+  static uint64_t reported = 0;
+  struct timespec interval = { 0, DRAIN_INTERVAL_NS };
+  while (!__atomic_load_n (&stop_requested, __ATOMIC_ACQUIRE))
+    {
+    nanosleep (&interval, NULL);
+    kasynclog_drain ();
+    kasynclog_report_dropped (&reported);
+    }
+  kasynclog_drain ();
+  kasynclog_report_dropped (&reported);
+  return NULL;
+  }
+
+/*============================================================================
+  
+  kasynclog_start
+
+  ==========================================================================*/
+BOOL kasynclog_start (int size)
+  {
+  if (running) return TRUE;
+  if (size <= 0) size = KASYNCLOG_DEFAULT_RING_SIZE;
+  ring_size = 1;
+  while (ring_size < size) ring_size *= 2;
+  stop_requested = FALSE;
+
+  // The background thread must not take signals that the program
+  //  expects to handle -- or, at least, to notice -- itself
+  sigset_t all, old;
+  sigfillset (&all);
+  pthread_sigmask (SIG_SETMASK, &all, &old);
+  int err = pthread_create (&drain_thread, NULL, kasynclog_thread, NULL);
+  pthread_sigmask (SIG_SETMASK, &old, NULL);
+  if (err != 0) return FALSE;
+
+  running = TRUE;
+  klog_set_handler (kasynclog_handler);
+  return TRUE;
+  }
+
+/*============================================================================
+  
+  kasynclog_stop
+
+  ==========================================================================*/
+void kasynclog_stop (void)
+  {
+  if (!running) return;
+  klog_set_handler (NULL);
+  __atomic_store_n (&stop_requested, TRUE, __ATOMIC_RELEASE);
+  pthread_join (drain_thread, NULL);
+  running = FALSE;
+  }
+
+/*============================================================================
+  
+  kasynclog_get_dropped
+
+  ==========================================================================*/
+uint64_t kasynclog_get_dropped (void)
+  {
+  return __atomic_load_n (&dropped, __ATOMIC_RELAXED);
+  }
+
@@ -0,0 +1,420 @@
+/*============================================================================
+  
+  klib
+  
+  kjsonwriter.c
+
+  Copyright (c)1990-2020 Kevin Boone. Distributed under the terms of the
+  GNU Public Licence, v3.0
+
+  ==========================================================================*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <assert.h>
+#include <klib/klog.h>
+#include <klib/kjsonwriter.h>
+
+#define KLOG_CLASS "klib.kjsonwriter"
+
+#define INITIAL_SIZE 1024
+
+/*============================================================================
+  
+  KJsonWriter
+
+  ==========================================================================*/
+struct _KJsonWriter
+  {
+  char *buff;
+  size_t length;   // Not including the terminating nul
+  size_t size;     // Allocated size
+  BOOL own_buff;   // buff is ours to free
+  int depth;
+  int flags[KJSONWRITER_MAX_DEPTH];
+  int count[KJSONWRITER_MAX_DEPTH];  // Values written at each depth
+  BOOL after_key;  // A key has been written, so no separator is needed
+  };
+
+/*============================================================================
+  
+  kjsonwriter_new
+
+  ==========================================================================*/
+KJsonWriter *kjsonwriter_new (void)
+  {
+  KLOG_IN
+  KJsonWriter *self = malloc (sizeof (KJsonWriter));
+  memset (self, 0, sizeof (KJsonWriter));
+  KLOG_OUT
+  return self;
+  }
+
+/*============================================================================
+  
+  kjsonwriter_new_with_buffer
+
+  ==========================================================================*/
+KJsonWriter *kjsonwriter_new_with_buffer (char *buff, size_t size)
+  {
+  KLOG_IN
+  KJsonWriter *self = kjsonwriter_new ();
+  if (size > 0)
+    {
+    self->buff = buff;
+    self->size = size;
+    self->buff[0] = 0;
+    }
+  KLOG_OUT
+  return self;
+  }
+
+/*============================================================================
+  
+  kjsonwriter_destroy
+
+  ==========================================================================*/
+void kjsonwriter_destroy (KJsonWriter *self)
+  {
+  KLOG_IN
+  if (self)
+    {
+    if (self->own_buff) free (self->buff);
+    free (self);
+    }
+  KLOG_OUT
+  }
+
+/*============================================================================
+  
+  kjsonwriter_reset
+
+  ==========================================================================*/
+void kjsonwriter_reset (KJsonWriter *self)
+  {
+  KLOG_IN
+  self->length = 0;
+  if (self->buff) self->buff[0] = 0;
+  self->depth = 0;
+  self->count[0] = 0;
+  self->after_key = FALSE;
+  KLOG_OUT
+  }
+
+/*============================================================================
+  
+  kjsonwriter_reserve
+
+  Make sure there is space for n more bytes, and a terminator
+
+  ==========================================================================*/
+static void kjsonwriter_reserve (KJsonWriter *self, size_t n)
+  {
+  size_t needed = self->length + n + 1;
+  if (needed <= self->size) return;
+  size_t new_size = self->size ? self->size : INITIAL_SIZE;
+  while (new_size < needed) new_size *= 2;
+  if (self->own_buff)
+    self->buff = realloc (self->buff, new_size);
+  else
+    {
+    char *new_buff = malloc (new_size);
+    if (self->length) memcpy (new_buff, self->buff, self->length);
+    self->buff = new_buff;
+    self->own_buff = TRUE;
+    }
+  self->size = new_size;
+  }
+
+/*============================================================================
+  
+  kjsonwriter_raw
+
+  ==========================================================================*/
+void kjsonwriter_raw (KJsonWriter *self, const char *s, size_t len)
+  {
+  kjsonwriter_reserve (self, len);
+  memcpy (self->buff + self->length, s, len);
+  self->length += len;
+  self->buff[self->length] = 0;
+  }
+
+/*============================================================================
+  
+  kjsonwriter_char
+
+  ==========================================================================*/
+static void kjsonwriter_char (KJsonWriter *self, char c)
+  {
+  kjsonwriter_reserve (self, 1);
+  self->buff[self->length++] = c;
+  self->buff[self->length] = 0;
+  }
+
+/*============================================================================
+  
+  kjsonwriter_separate
+
+  Called before every value or key: writes the separator, if this is
+  not the first item in its container.
+
+  ==========================================================================*/
+static void kjsonwriter_separate (KJsonWriter *self)
+  {
+  if (self->after_key)
+    {
+    self->after_key = FALSE;
+    return;
+    }
+  int d = self->depth;
+  if (self->count[d] > 0)
+    {
+    if (self->flags[d] & KJSONWRITER_NEWLINES)
+      kjsonwriter_raw (self, ",\n", 2);
+    else
+      kjsonwriter_char (self, ',');
+    }
+  self->count[d]++;
+  }
+
+/*============================================================================
+  
+  kjsonwriter_begin
+
+  ==========================================================================*/
+static void kjsonwriter_begin (KJsonWriter *self, char c, int flags)
+  {
+  kjsonwriter_separate (self);
+  kjsonwriter_char (self, c);
+  assert (self->depth < KJSONWRITER_MAX_DEPTH - 1);
+  self->depth++;
+  self->flags[self->depth] = flags;
+  self->count[self->depth] = 0;
+  }
+
+/*============================================================================
+  
+  kjsonwriter_end
+
+  ==========================================================================*/
+static void kjsonwriter_end (KJsonWriter *self, char c)
+  {
+  assert (self->depth > 0);
+  self->depth--;
+  kjsonwriter_char (self, c);
+  }
+
+/*============================================================================
+  
+  kjsonwriter_begin_object etc
+
+  ==========================================================================*/
+void kjsonwriter_begin_object (KJsonWriter *self, int flags)
+  {
+  kjsonwriter_begin (self, '{', flags);
+  }
+
+void kjsonwriter_end_object (KJsonWriter *self)
+  {
+  kjsonwriter_end (self, '}');
+  }
+
+void kjsonwriter_begin_array (KJsonWriter *self, int flags)
+  {
+  kjsonwriter_begin (self, '[', flags);
+  }
+
+void kjsonwriter_end_array (KJsonWriter *self)
+  {
+  kjsonwriter_end (self, ']');
+  }
+
+/*============================================================================
+  
+  kjsonwriter_quoted
+
+  Write a string in quotes, escaping what JSON requires to be escaped.
+  Bytes outside ASCII are assumed to be UTF-8, and are copied as they
+  are.
+
+  ==========================================================================*/
+static void kjsonwriter_quoted (KJsonWriter *self, const char *s)
+  {
+  size_t len = strlen (s);
+  kjsonwriter_reserve (self, len + 2);
+  kjsonwriter_char (self, '"');
+  const char *start = s;
+  for (; *s; s++)
+    {
+    unsigned char c = (unsigned char)*s;
+    if (c < 0x20 || c == '"' || c == '\\')
+      {
+      kjsonwriter_raw (self, start, s - start);
+      char esc[8];
+      switch (c)
+        {
+        case '"': strcpy (esc, "\\\""); break;
+        case '\\': strcpy (esc, "\\\\"); break;
+        case '\n': strcpy (esc, "\\n"); break;
+        case '\r': strcpy (esc, "\\r"); break;
+        case '\t': strcpy (esc, "\\t"); break;
+        default: snprintf (esc, sizeof (esc), "\\u%04x", c);
+        }
+      kjsonwriter_raw (self, esc, strlen (esc));
+      start = s + 1;
+      }
+    }
+  kjsonwriter_raw (self, start, s - start);
+  kjsonwriter_char (self, '"');
+  }
+
+/*============================================================================
+  
+  kjsonwriter_key
+
+  ==========================================================================*/
+void kjsonwriter_key (KJsonWriter *self, const char *key)
+  {
+  kjsonwriter_separate (self);
+  kjsonwriter_quoted (self, key);
+  kjsonwriter_char (self, ':');
+  self->after_key = TRUE;
+  }
+
+/*============================================================================
+  
+  kjsonwriter_string
+
+  ==========================================================================*/
+void kjsonwriter_string (KJsonWriter *self, const char *s)
+  {
+  kjsonwriter_separate (self);
+  if (s)
+    kjsonwriter_quoted (self, s);
+  else
+    kjsonwriter_raw (self, "null", 4);
+  }
+
+/*============================================================================
+  
+  kjsonwriter_number
+
+  ==========================================================================*/
+void kjsonwriter_number (KJsonWriter *self, double n)
+  {
+  kjsonwriter_separate (self);
+  char s[32];
+  int len = snprintf (s, sizeof (s), "%g", n);
+  kjsonwriter_raw (self, s, len);
+  }
+
+/*============================================================================
+  
+  kjsonwriter_int
+
+  ==========================================================================*/
+void kjsonwriter_int (KJsonWriter *self, int64_t n)
+  {
+  kjsonwriter_separate (self);
+  char s[32];
+  int len = snprintf (s, sizeof (s), "%" PRId64, n);
+  kjsonwriter_raw (self, s, len);
+  }
+
+/*============================================================================
+  
+  kjsonwriter_bool
+
+  ==========================================================================*/
+void kjsonwriter_bool (KJsonWriter *self, BOOL b)
+  {
+  kjsonwriter_separate (self);
+  if (b)
+    kjsonwriter_raw (self, "true", 4);
+  else
+    kjsonwriter_raw (self, "false", 5);
+  }
+
+/*============================================================================
+  
+  kjsonwriter_null
+
+  ==========================================================================*/
+void kjsonwriter_null (KJsonWriter *self)
+  {
+  kjsonwriter_separate (self);
+  kjsonwriter_raw (self, "null", 4);
+  }
+
+/*============================================================================
+  
+  kjsonwriter_json
+
+  ==========================================================================*/
+void kjsonwriter_json (KJsonWriter *self, const char *json, size_t len)
+  {
+  kjsonwriter_separate (self);
+  kjsonwriter_raw (self, json, len);
+  }
+
+/*============================================================================
+  
+  kjsonwriter_newline
+
+  ==========================================================================*/
+void kjsonwriter_newline (KJsonWriter *self)
+  {
+  kjsonwriter_char (self, '\n');
+  }
+
+/*============================================================================
+  
+  kjsonwriter_get_data
+
+  ==========================================================================*/
+const char *kjsonwriter_get_data (const KJsonWriter *self)
+  {
+  return self->buff ? self->buff : "";
+  }
+
+/*============================================================================
+  
+  kjsonwriter_get_length
+
+  ==========================================================================*/
+size_t kjsonwriter_get_length (const KJsonWriter *self)
+  {
+  return self->length;
+  }
+
+/*============================================================================
+  
+  kjsonwriter_to_utf8
+
+  ==========================================================================*/
+char *kjsonwriter_to_utf8 (KJsonWriter *self)
+  {
+  KLOG_IN
+  char *ret;
+  if (self->own_buff)
+    {
+    // Hand over our buffer, rather than copying it
+    ret = self->buff;
+    self->buff = NULL;
+    self->size = 0;
+    self->own_buff = FALSE;
+    }
+  else
+    {
+    ret = malloc (self->length + 1);
+    memcpy (ret, kjsonwriter_get_data (self), self->length);
+    ret[self->length] = 0;
+    self->buff = NULL;
+    self->size = 0;
+    }
+  kjsonwriter_reset (self);
+  KLOG_OUT
+  return ret;
+  }
+
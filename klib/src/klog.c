@@ -151,12 +151,20 @@ void klog_v (KLogLevel level, const char *cls, const char *fmt,
                      va_list ap)
   {
   if (level > log_level) return;
-  char *s;
-  vasprintf (&s, fmt, ap);
+  // Format on the stack; only an unusually long message needs an
+  //  allocation
+  char buff[512];
+  char *s = buff;
+  va_list ap2;
+  va_copy (ap2, ap);
+  int n = vsnprintf (buff, sizeof (buff), fmt, ap);
+  if (n >= (int)sizeof (buff))
+    vasprintf (&s, fmt, ap2);
+  va_end (ap2);
   if (log_handler)
     log_handler (level, cls, log_user_data, s);
   else
     fprintf (stderr, "%s %s: %s\n", klog_level_to_utf8 (level), cls, s);
-  free (s);
+  if (s != buff) free (s);
   }
 
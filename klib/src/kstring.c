@@ -21,17 +21,80 @@
 
 #define KLOG_CLASS "klib.kstring"
 
+// Number of characters, not including the terminator, that can be 
+//  stored in the KString object itself, without a separate allocation
+#define KSTRING_INLINE 15
+
 /*============================================================================
   
   KString 
 
+  str points either to inline, or to a heap block with room for 
+  capacity characters and a terminator. Appending grows the capacity
+  geometrically, so building a string by appending is linear in its
+  final length, rather than quadratic.
+
   ==========================================================================*/
 struct _KString
   {
   size_t length;
+  size_t capacity;
   UTF32 *str;
+  UTF32 inline_str[KSTRING_INLINE + 1];
   };
 
+/*============================================================================
+  
+  kstring_init
+
+  ==========================================================================*/
+static void kstring_init (KString *self)
+  {
+  self->str = self->inline_str;
+  self->str[0] = 0;
+  self->length = 0;
+  self->capacity = KSTRING_INLINE;
+  }
+
+/*============================================================================
+  
+  kstring_set_capacity
+
+  Move the string to a buffer of exactly the specified capacity, which
+  must be at least the current length
+
+  ==========================================================================*/
+static void kstring_set_capacity (KString *self, size_t capacity)
+  {
+  if (self->str == self->inline_str)
+    {
+    UTF32 *str = malloc ((capacity + 1) * sizeof (UTF32));
+    memcpy (str, self->str, (self->length + 1) * sizeof (UTF32));
+    self->str = str;
+    }
+  else
+    self->str = realloc (self->str, (capacity + 1) * sizeof (UTF32));
+  self->capacity = capacity;
+  }
+
+/*============================================================================
+  
+  kstring_reserve
+
+  ==========================================================================*/
+void kstring_reserve (KString *self, size_t capacity)
+  {
+  KLOG_IN
+  assert (self != NULL);
+  if (capacity > self->capacity)
+    {
+    size_t new_capacity = self->capacity * 2;
+    if (new_capacity < capacity) new_capacity = capacity;
+    kstring_set_capacity (self, new_capacity);
+    }
+  KLOG_OUT
+  }
+
 
 /*============================================================================
   
@@ -42,9 +105,7 @@ KString *kstring_new_empty (void)
   {
   KLOG_IN
   KString *self = malloc (sizeof (KString));
-  self->str = malloc(1 * sizeof (UTF32));
-  self->str[0] = 0;
-  self->length = 0;
+  kstring_init (self);
   KLOG_OUT
   return self;
   }
@@ -60,20 +121,8 @@ KString *kstring_new_from_utf8 (const UTF8 *_in)
   KLOG_IN
   assert (_in != NULL);
   KString *self = malloc (sizeof (KString));
-
-  const UTF8* in = (UTF8 *)_in;
-  int max_out = strlen ((char *)_in); // This is an absolute maximum
-  UTF32 *out = malloc ((max_out + 1) * sizeof (UTF32));
-  memset (out, 0, max_out * sizeof (UTF32));
-  UTF32 *out_temp = out;
-
-  ConvertUTF8toUTF32 ((const UTF8 **)&in, (const UTF8 *)in+strlen((char *)in),
-      &out_temp, out + max_out, 0);
-
-  int len = out_temp - out;
-  out [len] = 0;
-  self->str = out;
-  self->length = len;
+  kstring_init (self);
+  kstring_append_utf8 (self, _in);
   KLOG_OUT
   return self;
   }
@@ -89,9 +138,8 @@ KString *kstring_new_from_utf32 (const UTF32 *s)
   KLOG_IN
   assert (s != NULL);
   KString *self = malloc (sizeof (KString));
-  self->length = kstring_length_utf32 (s);
-  self->str = malloc ((self->length + 1) * sizeof (UTF32));
-  memcpy (self->str, s, (self->length + 1) * sizeof (UTF32));
+  kstring_init (self);
+  kstring_append_utf32 (self, s);
   KLOG_OUT
   return self;
   }
@@ -106,7 +154,7 @@ void kstring_destroy (KString *self)
   KLOG_IN
   if (self)
     {
-    if (self->str) free (self->str);
+    if (self->str != self->inline_str) free (self->str);
     free (self);
     }
   KLOG_OUT
@@ -139,8 +187,8 @@ void kstring_append (KString *self, const KString *s)
   KLOG_IN
   assert (self != NULL);
   assert (s != NULL);
-  int newlen = self->length + s->length;
-  self->str = realloc (self->str, (newlen + 1) * sizeof (UTF32));
+  size_t newlen = self->length + s->length;
+  kstring_reserve (self, newlen);
   memcpy (self->str + self->length, s->str, (s->length * sizeof (UTF32)));
   self->length = newlen;
   self->str [self->length] = 0;
@@ -149,10 +197,7 @@ void kstring_append (KString *self, const KString *s)
 
 /*============================================================================
   
-  kstring_append_printf
-
-  Better hope the C library memory allocator is efficient, because this
-    implementation is not :/
+  kstring_append_char
 
   ==========================================================================*/
 void kstring_append_char (KString *self, UTF32 c)
@@ -161,7 +206,7 @@ void kstring_append_char (KString *self, UTF32 c)
   assert (self != NULL);
   assert (self->str != NULL);
 
-  self->str = realloc (self->str, (self->length + 2) * sizeof (UTF32)); 
+  kstring_reserve (self, self->length + 1); 
   self->str[self->length] = c;
   self->str[self->length + 1] = 0;
   self->length += 1;
@@ -179,13 +224,24 @@ void kstring_append_printf (KString *self, char *fmt,...)
   KLOG_IN
   assert (self != NULL);
   assert (fmt != NULL);
+  // Most formatted output is short enough to go on the stack; only
+  //  if it is not do we need an allocation
+  char buff[256];
   va_list ap;
   va_start (ap, fmt);
-  char *s;
-  vasprintf (&s, fmt, ap);
-  kstring_append_utf8 (self, (UTF8*)s);
-  free (s);
+  int n = vsnprintf (buff, sizeof (buff), fmt, ap);
   va_end (ap);
+  if (n < (int)sizeof (buff))
+    kstring_append_utf8 (self, (UTF8*)buff);
+  else
+    {
+    char *s;
+    va_start (ap, fmt);
+    vasprintf (&s, fmt, ap);
+    va_end (ap);
+    kstring_append_utf8 (self, (UTF8*)s);
+    free (s);
+    }
   KLOG_OUT
   }
 
@@ -198,9 +254,15 @@ void kstring_append_utf8 (KString *self, const UTF8 *s)
   {
   KLOG_IN
   assert (s != NULL);
-  KString *temp = kstring_new_from_utf8 (s);
-  kstring_append (self, temp);
-  kstring_destroy (temp);
+  // Each UTF8 byte makes at most one UTF32 character, so converting 
+  //  straight into the end of the string can't overflow it
+  size_t l = strlen ((char *)s);
+  kstring_reserve (self, self->length + l);
+  const UTF8 *in = s;
+  UTF32 *out = self->str + self->length;
+  ConvertUTF8toUTF32 (&in, s + l, &out, out + l, 0);
+  self->length = out - self->str;
+  self->str[self->length] = 0;
   KLOG_OUT
   }
 
@@ -212,7 +274,12 @@ void kstring_append_utf8 (KString *self, const UTF8 *s)
 void kstring_append_utf32 (KString *self, const UTF32 *s)
   {
   KLOG_IN
-  kstring_append_utf32 (self, s);
+  assert (self != NULL);
+  assert (s != NULL);
+  size_t l = kstring_length_utf32 (s);
+  kstring_reserve (self, self->length + l);
+  memcpy (self->str + self->length, s, (l + 1) * sizeof (UTF32));
+  self->length += l;
   KLOG_OUT
   }
 
@@ -240,8 +307,7 @@ void kstring_clear (KString *self)
   KLOG_IN
   assert (self != NULL);
   assert (self->str != NULL);
-  free (self->str);
-  self->str = malloc (sizeof (UTF32));
+  // Keep the buffer, as the string will probably be refilled
   self->str[0] = 0;
   self->length = 0;
   KLOG_OUT
@@ -255,18 +321,13 @@ void kstring_clear (KString *self)
 void kstring_delete (KString *self, int pos, int len)
   {
   KLOG_IN
-  UTF32 *str = self->str;
   int lself = self->length; 
   if (pos + len > lself)
-    kstring_delete (self, pos, lself - len);
-  else
+    len = lself - pos;
+  if (len > 0)
     {
-    UTF32 *buff = malloc ((lself - len + 2) * sizeof (UTF32));
-    memcpy (buff, str, pos  * sizeof (UTF32));
-    memcpy (buff + pos, str + pos + len,
-      (1 + kstring_length_utf32 (str + pos + len)) * sizeof (UTF32));
-    free (self->str);
-    self->str = buff;
+    memmove (self->str + pos, self->str + pos + len, 
+      (lself - pos - len + 1) * sizeof (UTF32));
     self->length -= len;
     }
   KLOG_OUT 
@@ -607,11 +668,11 @@ KString *kstring_substring (const KString *self, int start, int count)
     count = self->length - start;
   if (count + start >= self->length) 
     count = self->length - start;
-  UTF32 *s = malloc ((count + 1) * sizeof (UTF32));
-  memcpy (s, self->str + start, count  * sizeof (UTF32));
-  s[count] = 0;
-  KString *ret = kstring_new_from_utf32 (s);
-  free (s);
+  KString *ret = kstring_new_empty ();
+  kstring_reserve (ret, count);
+  memcpy (ret->str, self->str + start, count  * sizeof (UTF32));
+  ret->str[count] = 0;
+  ret->length = count;
   KLOG_OUT
   return ret; 
   }
@@ -740,10 +801,7 @@ void kstring_trim_left (KString *self)
     }
 
   int new_len = l - pos;
-  UTF32 *s_new = malloc ((new_len + 1) * sizeof (UTF32));
-  memcpy (s_new, self->str + pos, (new_len + 1) * sizeof (UTF32));
-  free (self->str);
-  self->str = s_new;
+  memmove (self->str, self->str + pos, (new_len + 1) * sizeof (UTF32));
   self->length = new_len; 
   KLOG_OUT
   }
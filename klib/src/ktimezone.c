@@ -0,0 +1,967 @@
+/*============================================================================
+
+  klib
+
+  ktimezone.c
+
+  A thread-safe replacement for TZ/tzset() based time conversion. Each
+  zone is read once from its TZif file (RFC 8536) into a table of
+  transition times, plus the POSIX TZ rule from the file's footer, which
+  covers times after the last explicit transition.
+
+  Copyright (c)1990-2020 Kevin Boone. Distributed under the terms of the
+  GNU Public Licence, v3.0
+
+  ==========================================================================*/
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <ctype.h>
+#include <pthread.h>
+#include <klib/klog.h>
+#include <klib/ktimezone.h>
+
+#define KLOG_CLASS "klib.ktimezone"
+
+#define SECS_PER_DAY (24 * 3600)
+
+// Largest zone file we're prepared to read. Real ones are a few kB
+#define MAX_TZIF_SIZE (1024 * 1024)
+
+// Size of the TZif header, in bytes
+#define TZIF_HEADER_SIZE 44
+
+// Number of hash buckets in the registry of loaded zones
+#define REGISTRY_BUCKETS 64
+
+// Longest abbreviation we'll take from a POSIX TZ rule
+#define MAX_ABBR 16
+
+#define DEFAULT_TZDIR "/usr/share/zoneinfo"
+
+// Zones returned by ktimezone_get() have their rules expanded into
+//   explicit transitions up to the end of this year. Later times are
+//   still handled, but by evaluating the rule
+#define KTIMEZONE_COMPILE_TO_YEAR 2100
+
+/*============================================================================
+
+  KTimeZoneType
+
+  One local time type -- an offset from UTC, with its DST flag and
+  abbreviation, e.g., +3600, TRUE, "BST"
+
+  ==========================================================================*/
+typedef struct _KTimeZoneType
+  {
+  int32_t offset; // Seconds east of UTC
+  BOOL isdst;
+  const char *abbr;
+  } KTimeZoneType;
+
+/*============================================================================
+
+  KTimeZoneDate
+
+  The date part of a POSIX TZ rule: Jn, n, or Mm.w.d
+
+  ==========================================================================*/
+typedef enum
+  {
+  KTZ_DATE_JULIAN = 0, // Jn: 1-365, Feb 29 never counted
+  KTZ_DATE_DAY = 1,    // n: 0-365, Feb 29 counted
+  KTZ_DATE_MWD = 2     // Mm.w.d: day d of week w of month m
+  } KTimeZoneDateKind;
+
+typedef struct _KTimeZoneDate
+  {
+  KTimeZoneDateKind kind;
+  int month;
+  int week;
+  int day;
+  int32_t time; // Seconds after local midnight; can be negative
+  } KTimeZoneDate;
+
+/*============================================================================
+
+  KTimeZoneRule
+
+  A parsed POSIX TZ string, e.g., GMT0BST,M3.5.0/1,M10.5.0
+
+  ==========================================================================*/
+typedef struct _KTimeZoneRule
+  {
+  KTimeZoneType std;
+  KTimeZoneType dst;
+  BOOL has_dst;
+  KTimeZoneDate start;
+  KTimeZoneDate end;
+  char std_abbr[MAX_ABBR];
+  char dst_abbr[MAX_ABBR];
+  } KTimeZoneRule;
+
+/*============================================================================
+
+  KTimeZone
+
+  ==========================================================================*/
+struct _KTimeZone
+  {
+  char *name;
+  int ntrans;
+  int64_t *trans;           // Transition times, ascending
+  unsigned char *trans_type; // Index into types, for each transition
+  int ntypes;
+  KTimeZoneType *types;
+  char *abbrs;              // Abbreviation strings from the file
+  BOOL has_rule;
+  KTimeZoneRule rule;       // Applies after the last transition
+  };
+
+/*============================================================================
+
+  Registry of loaded zones
+
+  ==========================================================================*/
+typedef struct _KTimeZoneEntry
+  {
+  struct _KTimeZoneEntry *next;
+  char *name;
+  KTimeZone *zone; // NULL if the zone could not be loaded
+  } KTimeZoneEntry;
+
+static KTimeZoneEntry *registry[REGISTRY_BUCKETS];
+static pthread_rwlock_t registry_lock = PTHREAD_RWLOCK_INITIALIZER;
+
+static KTimeZoneType utc_type = {0, FALSE, "UTC"};
+static KTimeZone utc_zone = {(char *)"UTC", 0, NULL, NULL, 1, &utc_type,
+  NULL, FALSE};
+
+/*============================================================================
+
+  ktimezone_days_from_civil
+
+  Days since 1970-01-01 of the specified date in the proleptic Gregorian
+  calendar. Month is 1-12. See
+  http://howardhinnant.github.io/date_algorithms.html
+
+  ==========================================================================*/
+static int64_t ktimezone_days_from_civil (int64_t y, int m, int d)
+  {
+  y -= m <= 2;
+  int64_t era = (y >= 0 ? y : y - 399) / 400;
+  int64_t yoe = y - era * 400;
+  int64_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+  }
+
+/*============================================================================
+
+  ktimezone_year_from_days
+
+  The inverse of ktimezone_days_from_civil, but we only need the year
+
+  ==========================================================================*/
+static int64_t ktimezone_year_from_days (int64_t z)
+  {
+  z += 719468;
+  int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+  int64_t doe = z - era * 146097;
+  int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  int64_t mp = (5 * doy + 2) / 153;
+  int64_t m = mp + (mp < 10 ? 3 : -9);
+  return yoe + era * 400 + (m <= 2);
+  }
+
+/*============================================================================
+
+  ktimezone_is_leap
+
+  ==========================================================================*/
+static BOOL ktimezone_is_leap (int64_t y)
+  {
+  return (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+  }
+
+/*============================================================================
+
+  ktimezone_floor_div
+
+  ==========================================================================*/
+static int64_t ktimezone_floor_div (int64_t a, int64_t b)
+  {
+  int64_t q = a / b;
+  if ((a % b != 0) && ((a < 0) != (b < 0))) q--;
+  return q;
+  }
+
+/*============================================================================
+
+  ktimezone_rule_date_to_days
+
+  Get the day (days since the epoch) on which a rule date falls in the
+  specified year
+
+  ==========================================================================*/
+static int64_t ktimezone_rule_date_to_days (int64_t year,
+         const KTimeZoneDate *date)
+  {
+  static const int mdays[12] = {31,28,31,30,31,30,31,31,30,31,30,31};
+  int64_t jan1 = ktimezone_days_from_civil (year, 1, 1);
+  int64_t ret;
+  switch (date->kind)
+    {
+    case KTZ_DATE_JULIAN:
+      ret = jan1 + date->day - 1;
+      if (ktimezone_is_leap (year) && date->day >= 60) ret++;
+      break;
+    case KTZ_DATE_DAY:
+      ret = jan1 + date->day;
+      break;
+    default:
+      {
+      int64_t first = ktimezone_days_from_civil (year, date->month, 1);
+      int wday = (int)(((first + 4) % 7 + 7) % 7); // 1970-01-01 was Thu
+      int len = mdays[date->month - 1];
+      if (date->month == 2 && ktimezone_is_leap (year)) len++;
+      ret = first + (date->day - wday + 7) % 7 + (date->week - 1) * 7;
+      while (ret >= first + len) ret -= 7;
+      }
+    }
+  return ret;
+  }
+
+/*============================================================================
+
+  ktimezone_rule_transitions
+
+  Get the UTC times at which DST starts and ends in the specified year
+
+  ==========================================================================*/
+static void ktimezone_rule_transitions (const KTimeZoneRule *rule,
+         int64_t year, int64_t *start, int64_t *end)
+  {
+  *start = ktimezone_rule_date_to_days (year, &rule->start)
+    * SECS_PER_DAY + rule->start.time - rule->std.offset;
+  *end = ktimezone_rule_date_to_days (year, &rule->end)
+    * SECS_PER_DAY + rule->end.time - rule->dst.offset;
+  }
+
+/*============================================================================
+
+  ktimezone_rule_lookup
+
+  ==========================================================================*/
+static const KTimeZoneType *ktimezone_rule_lookup
+         (const KTimeZoneRule *rule, int64_t t)
+  {
+  if (!rule->has_dst) return &rule->std;
+
+  int64_t local = t + rule->std.offset;
+  int64_t year = ktimezone_year_from_days
+    (ktimezone_floor_div (local, SECS_PER_DAY));
+
+  int64_t start, end;
+  ktimezone_rule_transitions (rule, year, &start, &end);
+
+  BOOL dst;
+  if (start < end)
+    dst = (t >= start && t < end); // Northern hemisphere
+  else
+    dst = !(t >= end && t < start); // Southern -- DST spans new year
+  return dst ? &rule->dst : &rule->std;
+  }
+
+/*============================================================================
+
+  ktimezone_lookup
+
+  Find the local time type in effect at time t. This is a binary search
+  over the transition table, falling back to the POSIX rule after the
+  last transition.
+
+  ==========================================================================*/
+static const KTimeZoneType *ktimezone_lookup (const KTimeZone *self,
+          int64_t t)
+  {
+  int n = self->ntrans;
+  if (n == 0)
+    {
+    if (self->has_rule) return ktimezone_rule_lookup (&self->rule, t);
+    return &self->types[0];
+    }
+  if (t < self->trans[0])
+    return &self->types[0];
+
+  int lo = 0, hi = n - 1;
+  while (lo < hi)
+    {
+    int mid = (lo + hi + 1) / 2;
+    if (self->trans[mid] <= t)
+      lo = mid;
+    else
+      hi = mid - 1;
+    }
+
+  if (lo == n - 1 && self->has_rule)
+    return ktimezone_rule_lookup (&self->rule, t);
+  return &self->types[self->trans_type[lo]];
+  }
+
+/*============================================================================
+
+  ktimezone_parse_abbr
+
+  Parse the name part of a POSIX TZ string: either alphabetic, or
+  anything in <...>
+
+  ==========================================================================*/
+static BOOL ktimezone_parse_abbr (const char **p, char *abbr)
+  {
+  const char *s = *p;
+  int len = 0;
+  if (*s == '<')
+    {
+    s++;
+    while (*s && *s != '>')
+      {
+      if (len < MAX_ABBR - 1) abbr[len++] = *s;
+      s++;
+      }
+    if (*s != '>') return FALSE;
+    s++;
+    }
+  else
+    {
+    while (isalpha ((unsigned char)*s))
+      {
+      if (len < MAX_ABBR - 1) abbr[len++] = *s;
+      s++;
+      }
+    }
+  abbr[len] = 0;
+  *p = s;
+  return len >= 1;
+  }
+
+/*============================================================================
+
+  ktimezone_parse_hms
+
+  Parse [+-]hh[:mm[:ss]] into seconds
+
+  ==========================================================================*/
+static BOOL ktimezone_parse_hms (const char **p, int32_t *secs)
+  {
+  const char *s = *p;
+  int sign = 1;
+  if (*s == '+')
+    s++;
+  else if (*s == '-')
+    {
+    sign = -1;
+    s++;
+    }
+  if (!isdigit ((unsigned char)*s)) return FALSE;
+  int32_t h = 0, m = 0, sec = 0;
+  while (isdigit ((unsigned char)*s)) h = h * 10 + (*s++ - '0');
+  if (*s == ':')
+    {
+    s++;
+    while (isdigit ((unsigned char)*s)) m = m * 10 + (*s++ - '0');
+    if (*s == ':')
+      {
+      s++;
+      while (isdigit ((unsigned char)*s)) sec = sec * 10 + (*s++ - '0');
+      }
+    }
+  *secs = sign * (h * 3600 + m * 60 + sec);
+  *p = s;
+  return TRUE;
+  }
+
+/*============================================================================
+
+  ktimezone_parse_number
+
+  ==========================================================================*/
+static BOOL ktimezone_parse_number (const char **p, int *n)
+  {
+  const char *s = *p;
+  if (!isdigit ((unsigned char)*s)) return FALSE;
+  int v = 0;
+  while (isdigit ((unsigned char)*s)) v = v * 10 + (*s++ - '0');
+  *n = v;
+  *p = s;
+  return TRUE;
+  }
+
+/*============================================================================
+
+  ktimezone_parse_date
+
+  Parse a rule date Jn, n or Mm.w.d, and an optional /time
+
+  ==========================================================================*/
+static BOOL ktimezone_parse_date (const char **p, KTimeZoneDate *date)
+  {
+  const char *s = *p;
+  BOOL ok;
+  if (*s == 'J')
+    {
+    s++;
+    date->kind = KTZ_DATE_JULIAN;
+    ok = ktimezone_parse_number (&s, &date->day)
+      && date->day >= 1 && date->day <= 365;
+    }
+  else if (*s == 'M')
+    {
+    s++;
+    date->kind = KTZ_DATE_MWD;
+    ok = ktimezone_parse_number (&s, &date->month) && *s++ == '.'
+      && ktimezone_parse_number (&s, &date->week) && *s++ == '.'
+      && ktimezone_parse_number (&s, &date->day)
+      && date->month >= 1 && date->month <= 12
+      && date->week >= 1 && date->week <= 5
+      && date->day >= 0 && date->day <= 6;
+    }
+  else
+    {
+    date->kind = KTZ_DATE_DAY;
+    ok = ktimezone_parse_number (&s, &date->day)
+      && date->day >= 0 && date->day <= 365;
+    }
+
+  date->time = 2 * 3600;
+  if (ok && *s == '/')
+    {
+    s++;
+    ok = ktimezone_parse_hms (&s, &date->time);
+    }
+  *p = s;
+  return ok;
+  }
+
+/*============================================================================
+
+  ktimezone_parse_rule
+
+  Parse a POSIX TZ string, as found in the footer of a TZif file. Note
+  that POSIX offsets are positive _west_ of Greenwich, which is the
+  opposite of the convention everywhere else.
+
+  ==========================================================================*/
+static BOOL ktimezone_parse_rule (const char *s, KTimeZoneRule *rule)
+  {
+  KLOG_IN
+  BOOL ok = FALSE;
+  int32_t off;
+  memset (rule, 0, sizeof (KTimeZoneRule));
+  if (ktimezone_parse_abbr (&s, rule->std_abbr)
+       && ktimezone_parse_hms (&s, &off))
+    {
+    rule->std.offset = -off;
+    rule->std.isdst = FALSE;
+    rule->std.abbr = rule->std_abbr;
+    ok = TRUE;
+    if (*s)
+      {
+      ok = ktimezone_parse_abbr (&s, rule->dst_abbr);
+      if (ok)
+        {
+        rule->has_dst = TRUE;
+        rule->dst.offset = rule->std.offset + 3600;
+        rule->dst.isdst = TRUE;
+        rule->dst.abbr = rule->dst_abbr;
+        if (*s && *s != ',')
+          {
+          ok = ktimezone_parse_hms (&s, &off);
+          rule->dst.offset = -off;
+          }
+        }
+      if (ok)
+        {
+        if (*s == ',')
+          {
+          s++;
+          ok = ktimezone_parse_date (&s, &rule->start) && *s++ == ','
+            && ktimezone_parse_date (&s, &rule->end) && *s == 0;
+          }
+        else
+          {
+          // POSIX leaves the default implementation-defined. Like
+          //   the C library, use the current US rules
+          const char *deflt = "M3.2.0,M11.1.0";
+          ktimezone_parse_date (&deflt, &rule->start);
+          deflt++;
+          ktimezone_parse_date (&deflt, &rule->end);
+          ok = (*s == 0);
+          }
+        }
+      }
+    }
+  KLOG_OUT
+  return ok;
+  }
+
+/*============================================================================
+
+  ktimezone_be32, ktimezone_be64
+
+  ==========================================================================*/
+static int32_t ktimezone_be32 (const BYTE *p)
+  {
+  return (int32_t)(((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16)
+     | ((uint32_t)p[2] << 8) | (uint32_t)p[3]);
+  }
+
+static int64_t ktimezone_be64 (const BYTE *p)
+  {
+  return (int64_t)(((uint64_t)(uint32_t)ktimezone_be32 (p) << 32)
+     | (uint32_t)ktimezone_be32 (p + 4));
+  }
+
+/*============================================================================
+
+  ktimezone_parse_tzif
+
+  Parse the contents of a TZif file into self. For version 2+ files we
+  skip the 32-bit data block, and use the 64-bit one and the footer.
+
+  ==========================================================================*/
+static BOOL ktimezone_parse_tzif (KTimeZone *self, const BYTE *data,
+       size_t len)
+  {
+  KLOG_IN
+  BOOL ret = FALSE;
+  const BYTE *p = data;
+  const BYTE *end = data + len;
+  int tsize = 4;
+
+  if (len < TZIF_HEADER_SIZE || memcmp (data, "TZif", 4) != 0)
+    goto done;
+
+  for (int pass = 0; pass < 2; pass++)
+    {
+    if (end - p < TZIF_HEADER_SIZE || memcmp (p, "TZif", 4) != 0)
+      goto done;
+    char version = p[4];
+    int32_t isutcnt = ktimezone_be32 (p + 20);
+    int32_t isstdcnt = ktimezone_be32 (p + 24);
+    int32_t leapcnt = ktimezone_be32 (p + 28);
+    int32_t timecnt = ktimezone_be32 (p + 32);
+    int32_t typecnt = ktimezone_be32 (p + 36);
+    int32_t charcnt = ktimezone_be32 (p + 40);
+    if (isutcnt < 0 || isstdcnt < 0 || leapcnt < 0 || timecnt < 0
+         || typecnt <= 0 || typecnt > 256 || charcnt < 0)
+      goto done;
+    p += TZIF_HEADER_SIZE;
+
+    int64_t block = (int64_t)timecnt * tsize + timecnt + typecnt * 6
+      + charcnt + (int64_t)leapcnt * (tsize + 4) + isstdcnt + isutcnt;
+    if (end - p < block) goto done;
+
+    if (pass == 0 && version >= '2')
+      {
+      // Skip the legacy 32-bit data
+      p += block;
+      tsize = 8;
+      continue;
+      }
+
+    self->ntrans = timecnt;
+    self->trans = malloc ((timecnt + 1) * sizeof (int64_t));
+    self->trans_type = malloc (timecnt + 1);
+    for (int i = 0; i < timecnt; i++)
+      {
+      self->trans[i] = tsize == 8 ? ktimezone_be64 (p + i * 8)
+        : ktimezone_be32 (p + i * 4);
+      }
+    p += timecnt * tsize;
+    for (int i = 0; i < timecnt; i++)
+      {
+      if (p[i] >= typecnt) goto done;
+      self->trans_type[i] = p[i];
+      }
+    p += timecnt;
+
+    const BYTE *ttinfo = p;
+    p += typecnt * 6;
+    self->abbrs = malloc (charcnt + 1);
+    memcpy (self->abbrs, p, charcnt);
+    self->abbrs[charcnt] = 0;
+    p += charcnt;
+
+    self->ntypes = typecnt;
+    self->types = malloc (typecnt * sizeof (KTimeZoneType));
+    for (int i = 0; i < typecnt; i++)
+      {
+      const BYTE *tt = ttinfo + i * 6;
+      self->types[i].offset = ktimezone_be32 (tt);
+      self->types[i].isdst = tt[4] != 0;
+      if (tt[5] >= charcnt) goto done;
+      self->types[i].abbr = self->abbrs + tt[5];
+      }
+
+    p += (int64_t)leapcnt * (tsize + 4) + isstdcnt + isutcnt;
+
+    if (version >= '2' && p < end && *p == '\n')
+      {
+      // The footer is a POSIX TZ string between newlines
+      const BYTE *q = p + 1;
+      while (q < end && *q != '\n') q++;
+      if (q < end && q - p - 1 > 0)
+        {
+        char *footer = strndup ((const char *)p + 1, q - p - 1);
+        self->has_rule = ktimezone_parse_rule (footer, &self->rule);
+        if (!self->has_rule)
+          klog_warn (KLOG_CLASS, "Can't parse TZ rule '%s' in zone %s",
+            footer, self->name);
+        free (footer);
+        }
+      }
+    ret = TRUE;
+    break;
+    }
+
+done:
+  KLOG_OUT
+  return ret;
+  }
+
+/*============================================================================
+
+  ktimezone_new_from_file
+
+  ==========================================================================*/
+KTimeZone *ktimezone_new_from_file (const char *name, const char *path)
+  {
+  KLOG_IN
+  assert (name != NULL);
+  assert (path != NULL);
+  KTimeZone *self = NULL;
+  FILE *f = fopen (path, "rb");
+  if (f)
+    {
+    BYTE *data = malloc (MAX_TZIF_SIZE);
+    size_t len = fread (data, 1, MAX_TZIF_SIZE, f);
+    fclose (f);
+
+    self = malloc (sizeof (KTimeZone));
+    memset (self, 0, sizeof (KTimeZone));
+    self->name = strdup (name);
+    if (!ktimezone_parse_tzif (self, data, len))
+      {
+      klog_warn (KLOG_CLASS, "Can't parse timezone file %s", path);
+      ktimezone_destroy (self);
+      self = NULL;
+      }
+    free (data);
+    }
+  else
+    klog_debug (KLOG_CLASS, "Can't open timezone file %s", path);
+  KLOG_OUT
+  return self;
+  }
+
+/*============================================================================
+
+  ktimezone_destroy
+
+  ==========================================================================*/
+void ktimezone_destroy (KTimeZone *self)
+  {
+  KLOG_IN
+  if (self && self != &utc_zone)
+    {
+    if (self->name) free (self->name);
+    if (self->trans) free (self->trans);
+    if (self->trans_type) free (self->trans_type);
+    if (self->types) free (self->types);
+    if (self->abbrs) free (self->abbrs);
+    free (self);
+    }
+  KLOG_OUT
+  }
+
+/*============================================================================
+
+  ktimezone_hash
+
+  ==========================================================================*/
+static unsigned int ktimezone_hash (const char *s)
+  {
+  unsigned int h = 5381;
+  while (*s) h = h * 33 + (unsigned char)*s++;
+  return h % REGISTRY_BUCKETS;
+  }
+
+/*============================================================================
+
+  ktimezone_find_entry
+
+  Caller must hold the registry lock
+
+  ==========================================================================*/
+static KTimeZoneEntry *ktimezone_find_entry (const char *name,
+          unsigned int bucket)
+  {
+  KTimeZoneEntry *e = registry[bucket];
+  while (e && strcmp (e->name, name) != 0) e = e->next;
+  return e;
+  }
+
+/*============================================================================
+
+  ktimezone_compile
+
+  Expand the zone's POSIX rule into explicit transitions, up to the end
+  of the specified year, and append them to the transition table. 
+  Without this, every conversion of a time after the last transition in
+  the file -- which, with "slim" zone files, can be any time after the
+  rules last changed -- has to work out the DST dates for that year
+  from first principles. With it, every conversion up to last_year
+  is a binary search over a small, sorted array. 
+
+  ==========================================================================*/
+static void ktimezone_compile (KTimeZone *self, int last_year)
+  {
+  KLOG_IN
+  // The transition table stores type indices as bytes, so there must be
+  //   room for two more types
+  if (self->has_rule && self->rule.has_dst && self->ntrans > 0 
+       && self->ntypes <= 254)
+    {
+    int64_t last = self->trans[self->ntrans - 1];
+    int64_t first_year = ktimezone_year_from_days 
+      (ktimezone_floor_div (last, SECS_PER_DAY));
+    if (first_year <= last_year)
+      {
+      int max = self->ntrans + 2 * (last_year - first_year + 1);
+      self->trans = realloc (self->trans, max * sizeof (int64_t));
+      self->trans_type = realloc (self->trans_type, max);
+      self->types = realloc (self->types, 
+         (self->ntypes + 2) * sizeof (KTimeZoneType));
+      int std = self->ntypes;
+      int dst = self->ntypes + 1;
+      self->types[std] = self->rule.std;
+      self->types[dst] = self->rule.dst;
+      self->ntypes += 2;
+
+      int n = self->ntrans;
+      for (int64_t year = first_year; year <= last_year; year++)
+        {
+        int64_t start, end;
+        ktimezone_rule_transitions (&self->rule, year, &start, &end);
+        int64_t t[2];
+        int type[2];
+        if (start < end)
+          {
+          t[0] = start; type[0] = dst;
+          t[1] = end; type[1] = std;
+          }
+        else
+          {
+          t[0] = end; type[0] = std;
+          t[1] = start; type[1] = dst;
+          }
+        for (int i = 0; i < 2; i++)
+          {
+          if (t[i] > self->trans[n - 1])
+            {
+            self->trans[n] = t[i];
+            self->trans_type[n] = type[i];
+            n++;
+            }
+          }
+        }
+      klog_debug (KLOG_CLASS, "Compiled %d transitions for %s", 
+        n - self->ntrans, self->name);
+      self->ntrans = n;
+      }
+    }
+  KLOG_OUT
+  }
+
+/*============================================================================
+
+  ktimezone_load
+
+  ==========================================================================*/
+static KTimeZone *ktimezone_load (const char *name)
+  {
+  KLOG_IN
+  KTimeZone *ret = NULL;
+  // Don't let a zone name wander out of the zone directory
+  if (name[0] != 0 && name[0] != '/' && !strstr (name, ".."))
+    {
+    const char *dir = getenv ("TZDIR");
+    if (!dir || !dir[0]) dir = DEFAULT_TZDIR;
+    char *path;
+    if (asprintf (&path, "%s/%s", dir, name) >= 0)
+      {
+      ret = ktimezone_new_from_file (name, path);
+      if (ret) ktimezone_compile (ret, KTIMEZONE_COMPILE_TO_YEAR);
+      free (path);
+      }
+    }
+  if (!ret)
+    klog_warn (KLOG_CLASS, "Can't load timezone '%s'", name);
+  KLOG_OUT
+  return ret;
+  }
+
+/*============================================================================
+
+  ktimezone_get
+
+  ==========================================================================*/
+const KTimeZone *ktimezone_get (const char *name)
+  {
+  KLOG_IN
+  assert (name != NULL);
+  unsigned int bucket = ktimezone_hash (name);
+
+  pthread_rwlock_rdlock (&registry_lock);
+  KTimeZoneEntry *e = ktimezone_find_entry (name, bucket);
+  pthread_rwlock_unlock (&registry_lock);
+
+  if (!e)
+    {
+    pthread_rwlock_wrlock (&registry_lock);
+    // Another thread might have got here first
+    e = ktimezone_find_entry (name, bucket);
+    if (!e)
+      {
+      e = malloc (sizeof (KTimeZoneEntry));
+      e->name = strdup (name);
+      e->zone = ktimezone_load (name);
+      e->next = registry[bucket];
+      registry[bucket] = e;
+      }
+    pthread_rwlock_unlock (&registry_lock);
+    }
+
+  KLOG_OUT
+  return e->zone;
+  }
+
+/*============================================================================
+
+  ktimezone_get_utc
+
+  ==========================================================================*/
+const KTimeZone *ktimezone_get_utc (void)
+  {
+  return &utc_zone;
+  }
+
+/*============================================================================
+
+  ktimezone_get_name
+
+  ==========================================================================*/
+const char *ktimezone_get_name (const KTimeZone *self)
+  {
+  KLOG_IN
+  assert (self != NULL);
+  const char *ret = self->name;
+  KLOG_OUT
+  return ret;
+  }
+
+/*============================================================================
+
+  ktimezone_get_offset
+
+  ==========================================================================*/
+int ktimezone_get_offset (const KTimeZone *self, time_t t)
+  {
+  KLOG_IN
+  assert (self != NULL);
+  int ret = ktimezone_lookup (self, t)->offset;
+  KLOG_OUT
+  return ret;
+  }
+
+/*============================================================================
+
+  ktimezone_utc_to_local
+
+  ==========================================================================*/
+struct tm *ktimezone_utc_to_local (const KTimeZone *self, time_t t,
+          struct tm *tm)
+  {
+  KLOG_IN
+  assert (self != NULL);
+  assert (tm != NULL);
+  const KTimeZoneType *type = ktimezone_lookup (self, t);
+  time_t local = t + type->offset;
+  gmtime_r (&local, tm);
+  tm->tm_isdst = type->isdst;
+  tm->tm_gmtoff = type->offset;
+  tm->tm_zone = type->abbr;
+  KLOG_OUT
+  return tm;
+  }
+
+/*============================================================================
+
+  ktimezone_local_to_utc
+
+  Any change of offset that could affect a particular local time must
+  happen within a day of it. So we try the offsets in effect a day either
+  side, and see which of them is self-consistent.
+
+  ==========================================================================*/
+time_t ktimezone_local_to_utc (const KTimeZone *self, struct tm *tm)
+  {
+  KLOG_IN
+  assert (self != NULL);
+  assert (tm != NULL);
+  int isdst = tm->tm_isdst;
+  struct tm temp = *tm;
+  temp.tm_isdst = 0;
+  time_t local = timegm (&temp); // Normalizes out-of-range fields
+
+  const KTimeZoneType *before = ktimezone_lookup (self,
+    (int64_t)local - SECS_PER_DAY);
+  const KTimeZoneType *after = ktimezone_lookup (self,
+    (int64_t)local + SECS_PER_DAY);
+  time_t ta = local - before->offset;
+  time_t tb = local - after->offset;
+  const KTimeZoneType *type_a = ktimezone_lookup (self, ta);
+  const KTimeZoneType *type_b = ktimezone_lookup (self, tb);
+  BOOL valid_a = type_a->offset == before->offset;
+  BOOL valid_b = type_b->offset == after->offset;
+
+  time_t ret;
+  if (valid_a && valid_b && ta != tb)
+    {
+    // Ambiguous -- the same local time occurs twice
+    if (isdst >= 0 && (type_a->isdst != 0) != (isdst != 0)
+         && (type_b->isdst != 0) == (isdst != 0))
+      ret = tb;
+    else if (isdst >= 0 && (type_b->isdst != 0) != (isdst != 0)
+         && (type_a->isdst != 0) == (isdst != 0))
+      ret = ta;
+    else
+      ret = ta > tb ? ta : tb; // The later, usually standard time
+    }
+  else if (valid_a)
+    ret = ta;
+  else if (valid_b)
+    ret = tb;
+  else
+    ret = ta; // In a gap -- use the offset from before the change
+
+  ktimezone_utc_to_local (self, ret, tm);
+  KLOG_OUT
+  return ret;
+  }
+
@@ -87,23 +87,9 @@ void mathutil_get_negative_axis_crossings (double *x, double *y,
     double y2 = y[i + 1];
     if (y0 > 0 && y1 >= 0 && y2 < 0)
       {
-      double root1 = 0.0;
-      double root2 = 0.0;
-      double A = (0.5 * (y0 + y2)) - y1;
-      double B = (0.5 * (y2 - y0));
-      double C = y1;
-      double xExtreme = -B / (2.0 * A);
-      double discriminant = (B * B) - 4.0 * A * C;
-      if (discriminant >= 0.0)
-        { 
-        double DX = 0.5 * sqrt(discriminant) / fabs(A);
-        root1 = xExtreme - DX;
-        root2 = xExtreme + DX;
-        double bisect = 0;
-        if (fabs (root2) < 1.0)
-          bisect = root2;
-        else if (fabs (root1) < 1.0)
-          bisect = root1;
+      double bisect;
+      if (mathutil_interpolate_crossing (y0, y1, y2, &bisect))
+        {
         double xguess = x[i] + (bisect * (x[i] - x[i-1])); 
         mins[*nmins] = xguess;
         (*nmins)++;
@@ -132,23 +118,9 @@ void mathutil_get_positive_axis_crossings (double *x, double *y,
     double y2 = y[i + 1];
     if (y0 < 0 && y1 <= 0 && y2 > 0)
       {
-      double root1 = 0.0;
-      double root2 = 0.0;
-      double A = (0.5 * (y0 + y2)) - y1;
-      double B = (0.5 * (y2 - y0));
-      double C = y1;
-      double xExtreme = -B / (2.0 * A);
-      double discriminant = (B * B) - 4.0 * A * C;
-      if (discriminant >= 0.0)
-        { 
-        double DX = 0.5 * sqrt(discriminant) / fabs(A);
-        root1 = xExtreme - DX;
-        root2 = xExtreme + DX;
-        double bisect = 0;
-        if (fabs (root2) < 1.0)
-          bisect = root2;
-        else if (fabs (root1) < 1.0)
-          bisect = root1;
+      double bisect;
+      if (mathutil_interpolate_crossing (y0, y1, y2, &bisect))
+        {
         double xguess = x[i] + (bisect * (x[i] - x[i-1])); 
         mins[*nmins] = xguess;
         (*nmins)++;
@@ -158,6 +130,40 @@ void mathutil_get_positive_axis_crossings (double *x, double *y,
   KLOG_OUT
   }
 
+/*============================================================================
+  
+  mathutil_interpolate_crossing
+
+  ==========================================================================*/
+BOOL mathutil_interpolate_crossing (double y0, double y1, double y2, 
+        double *offset)
+  {
+  KLOG_IN
+  BOOL ret = FALSE;
+  double root1 = 0.0;
+  double root2 = 0.0;
+  double A = (0.5 * (y0 + y2)) - y1;
+  double B = (0.5 * (y2 - y0));
+  double C = y1;
+  double xExtreme = -B / (2.0 * A);
+  double discriminant = (B * B) - 4.0 * A * C;
+  if (discriminant >= 0.0)
+    { 
+    double DX = 0.5 * sqrt(discriminant) / fabs(A);
+    root1 = xExtreme - DX;
+    root2 = xExtreme + DX;
+    double bisect = 0;
+    if (fabs (root2) < 1.0)
+      bisect = root2;
+    else if (fabs (root1) < 1.0)
+      bisect = root1;
+    *offset = bisect;
+    ret = TRUE;
+    }
+  KLOG_OUT
+  return ret;
+  }
+
 /*============================================================================
   
   mathutil_pascal_frac
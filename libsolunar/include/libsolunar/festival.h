@@ -18,6 +18,17 @@
 struct _Festival;
 typedef struct _Festival Festival;
 
+/** The equinoxes and solstices, named by month, since which is the
+    summer solstice depends on the hemisphere. */
+typedef enum
+  {
+  FESTIVAL_MARCH_EQUINOX = 0,
+  FESTIVAL_JUNE_SOLSTICE,
+  FESTIVAL_SEPTEMBER_EQUINOX,
+  FESTIVAL_DECEMBER_SOLSTICE,
+  FESTIVAL_NUM_SEASONS
+  } FestivalSeason;
+
 BEGIN_DECLS
 
 extern void festival_destroy (Festival *self);
@@ -25,22 +36,51 @@ extern void festival_destroy (Festival *self);
 extern time_t festival_get_date (const Festival *self);
 extern const char *festival_get_name (const Festival *self);
 
+/* The dates of the festivals that depend on Easter are at 02:00 local 
+   time in the specified zone or, if zone is NULL, in the zone of the
+   process. The equinoxes and solstices are instants, and do not depend
+   on the zone. The process environment is never changed, so these 
+   functions are safe to call from multiple threads. */
 extern Festival *festival_get_autumnal_equinox (int year);
-extern Festival *festival_get_ash_wednesday (int year, const char *tz);
-extern Festival *festival_get_easter_sunday (int year, const char *tz);
-extern Festival *festival_get_easter_monday (int year, const char *tz);
-extern Festival *festival_get_good_friday (int year, const char *tz);
-extern Festival *festival_get_maundy_thursday (int year, const char *tz);
-extern Festival *festival_get_mothering_sunday (int year, const char *tz);
-extern Festival *festival_get_palm_sunday (int year, const char *tz);
-extern Festival *festival_get_shrove_tuesday (int year, const char *tz);
+extern Festival *festival_get_ash_wednesday (int year, 
+                   const KTimeZone *zone);
+extern Festival *festival_get_easter_sunday (int year, 
+                   const KTimeZone *zone);
+extern Festival *festival_get_easter_monday (int year, 
+                   const KTimeZone *zone);
+extern Festival *festival_get_good_friday (int year, 
+                   const KTimeZone *zone);
+extern Festival *festival_get_maundy_thursday (int year, 
+                   const KTimeZone *zone);
+extern Festival *festival_get_mothering_sunday (int year, 
+                   const KTimeZone *zone);
+extern Festival *festival_get_palm_sunday (int year, 
+                   const KTimeZone *zone);
+extern Festival *festival_get_shrove_tuesday (int year, 
+                   const KTimeZone *zone);
 extern Festival *festival_get_summer_solstice (int year, BOOL southern);
-extern Festival *festival_get_whitsun (int year, const char *tz);
+extern Festival *festival_get_whitsun (int year, 
+                   const KTimeZone *zone);
 extern Festival *festival_get_vernal_equinox (int year);
 extern Festival *festival_get_winter_solstice (int year, BOOL southern);
 
+/* Get the instant of one equinox or solstice. The results for 1900-2200
+   come from a table, which is filled in the first time any of them is
+   asked for; other years are worked out as they are asked for. */
+extern time_t festival_get_season (int year, FestivalSeason season);
+
+/* Get the instants of the equinoxes and solstices for nyears years 
+   from first_year. seasons[e] is an array of nyears time_t values, 
+   which receives the instants of event e for each year, or NULL if 
+   event e is not wanted. */
+extern void festival_get_seasons (int first_year, int nyears, 
+                  time_t *seasons[FESTIVAL_NUM_SEASONS]);
+
 extern BOOL festival_has_time (const Festival *self);
-extern KString *festival_to_string (const Festival *self, const char *tz);
+/* Describe the festival, with its date in the specified zone, or in the
+   zone of the process if zone is NULL. */
+extern KString *festival_to_string (const Festival *self, 
+                  const KTimeZone *zone);
 
 END_DECLS
 
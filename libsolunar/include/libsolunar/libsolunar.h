@@ -14,6 +14,7 @@
 #include <libsolunar/moontimes.h>
 #include <libsolunar/sunephemera.h>
 #include <libsolunar/moonephemera.h>
+#include <libsolunar/moonposcache.h>
 #include <libsolunar/astroutil.h>
 #include <libsolunar/solcity.h>
 #include <libsolunar/solunardaysummary.h>
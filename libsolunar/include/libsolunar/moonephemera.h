@@ -12,8 +12,29 @@
 
 #include <klib/klib.h>
 
+/** Ways to compute the moon's position. SERIES evaluates the full lunar
+ * series at every call. CHEBYSHEV fits polynomials to the series, one
+ * day at a time, and evaluates those; each call then costs a few 
+ * multiply-adds once the day's polynomials have been fitted. Results 
+ * agree with the series to about a third of an arc-second, except for
+ * a few minutes either side of RA 12h, where the series itself is 
+ * unreliable and the polynomials are the more accurate. */
+typedef enum 
+  {
+  MOONEPHEMERA_SERIES = 0,
+  MOONEPHEMERA_CHEBYSHEV = 1
+  } MoonEphemeraBackend;
+
 BEGIN_DECLS
 
+/** Select the method used by moonephemera_get_ra_and_dec. The default is
+ * MOONEPHEMERA_SERIES. This should be called before any positions are 
+ * worked out, since positions already cached (e.g., by moonposcache) 
+ * will not be recalculated. */
+extern void moonephemera_set_backend (MoonEphemeraBackend backend);
+
+extern MoonEphemeraBackend moonephemera_get_backend (void);
+
 /** Get the moon's right ascension and declination at the specified
  * time. RA is in hours, dec in degrees. */
 extern void  moonephemera_get_ra_and_dec (time_t t, double *ra, double *dec);
@@ -0,0 +1,42 @@
+/*============================================================================
+  
+  libsolunar 
+  
+  moonposcache.h
+
+  A cache of the moon's right ascension and declination, at fixed 
+  intervals of UTC time. The moon's position depends only on the time, 
+  not on the observer, so one set of values serves every city. 
+  Positions are computed a whole UTC day at a time, the first time any
+  time in that day is asked for, and shared between threads.
+
+  Copyright (c)1990-2020 Kevin Boone. Distributed under the terms of the
+  GNU Public Licence, v3.0
+
+  ==========================================================================*/
+#pragma once
+
+#include <klib/klib.h>
+
+/** Spacing of the cached positions, in seconds. This matches the 
+ * sampling interval used by moontimes, and divides exactly into any
+ * timezone offset in current use, so that the samples for a local day 
+ * all fall on the grid. */
+#define MOONPOSCACHE_STEP (15*60)
+
+BEGIN_DECLS
+
+/** Get the moon's right ascension (hours) and declination (degrees) at
+ * the specified time. The results are exactly those of 
+ * moonephemera_get_ra_and_dec(). If t is a multiple of
+ * MOONPOSCACHE_STEP the values come from the cache; other times are
+ * computed directly. Safe to call from multiple threads. */
+extern void moonposcache_get_ra_and_dec (time_t t, double *ra, double *dec);
+
+/** Get the sine of the moon's altitude, as 
+ * moonephemera_get_sin_altitude(), but using cached positions. */
+extern double moonposcache_get_sin_altitude (double latitude, 
+                  double longitude, time_t t);
+
+END_DECLS
+
@@ -13,8 +13,26 @@
 #include <klib/klib.h>
 
 
+/** Methods for finding moonrise and moonset. SAMPLED works out the 
+ * moon's altitude every 15 minutes, and fits a parabola to the three
+ * samples around each crossing of the horizon. ADAPTIVE samples every
+ * two hours, narrows each crossing down to the second, and subdivides
+ * intervals in which the moon might graze the horizon. ADAPTIVE is 
+ * more accurate, and usually needs fewer positions. */
+typedef enum
+  {
+  MOONTIMES_SAMPLED = 0,
+  MOONTIMES_ADAPTIVE = 1
+  } MoonTimesSolver;
+
 BEGIN_DECLS
 
+/** Select the method used by all the functions in this module. The
+ * default is MOONTIMES_SAMPLED. */
+extern void moontimes_set_solver (MoonTimesSolver solver);
+
+extern MoonTimesSolver moontimes_get_solver (void);
+
 /* Determine moonrises in the specified time period, at the specific
  * location. The results are written into an array of time_t values
  * of size max. The number of moonrises, if any, is written to count.
@@ -28,7 +46,16 @@ extern void moontimes_get_moonrises (time_t start, time_t end,
 
 /* See get_moonrises */
 extern void moontimes_get_moonsets (time_t start, time_t end, 
-        double latitude, double longitude, time_t *rises, 
+        double latitude, double longitude, time_t *sets, 
         int max, int *count);
 
+/* Determine both moonrises and moonsets in the specified time period,
+ * with the same results as calling get_moonrises and get_moonsets,
+ * but at about half the cost, since the moon's altitude is only
+ * worked out once for each sample time. Nothing is allocated; the
+ * results are written to the caller's arrays. */
+extern void moontimes_get_moon_events (time_t start, time_t end, 
+        double latitude, double longitude, time_t *rises, int max_rises,
+        int *nrises, time_t *sets, int max_sets, int *nsets);
+
 END_DECLS
@@ -27,6 +27,21 @@ BEGIN_DECLS
  * of SolCity */
 extern KList *solcity_find_matching (const UTF8 *s);
 
+/** Find the city that matches the specified name, as 
+ * solcity_find_matching() does, but without building a list -- this
+ * function allocates nothing. Returns the number of matching cities.
+ * If there are any, the first is written to city; if not, city is set 
+ * to NULL. A result other than 1 usually means the name was ambiguous
+ * or wrong. */
+extern int solcity_find_unique (const UTF8 *s, const SolCity **city);
+
+/** Find the city nearest to the specified location, in degrees, 
+ * +north and +east. This is usually the best guess at the timezone of
+ * the location. The search takes time proportional to the logarithm 
+ * of the number of cities. */
+extern const SolCity *solcity_find_nearest (double latitude, 
+        double longitude);
+
 /** Get the latitude of the city, in degrees, +north. */
 extern double solcity_get_latitude (const SolCity *self);
 
@@ -39,6 +54,16 @@ const char *solcity_get_tz_name (const SolCity *self);
 /** Get the name, e.g., Europe/London. */
 const char *solcity_get_name (const SolCity *self);
 
+/** Get the timezone of the city. The zone is loaded the first time it
+ * is asked for, and then kept with the city. If the zone can't be 
+ * loaded, the result is UTC, so this never returns NULL. The zone 
+ * belongs to klib, and must not be destroyed. */
+extern const KTimeZone *solcity_get_zone (const SolCity *self);
+
+/** Load the timezones of all cities up front, so the first request for
+ * each city does not pay the cost of parsing its zone file. */
+extern void solcity_preload_zones (void);
+
 END_DECLS
 
 
@@ -10,6 +10,7 @@
   ==========================================================================*/
 #pragma once
 
+#include <stdint.h>
 #include <klib/klib.h>
 
 struct _SolunarDaySummary;
@@ -37,6 +38,14 @@ extern SolunarDaySummary *solunar_day_summary_create
         (time_t date, double latitude, double longitude, const char *city, 
 	 const char *tz);
 
+/** As solunar_day_summary_create, but with a zone object rather than a
+ * zone name, which saves looking up the zone. zone can be NULL, to 
+ * use local time. The zone must outlive the summary -- zones from
+ * ktimezone_get() last for the lifetime of the program. */
+extern SolunarDaySummary *solunar_day_summary_create_in_zone
+        (time_t date, double latitude, double longitude, const char *city, 
+	 const KTimeZone *zone);
+
 extern void   solunar_day_summary_destroy (SolunarDaySummary *self);
 
 /** Get the city name that was supplied when this object was created. 
@@ -112,5 +121,17 @@ extern time_t solunar_day_summary_get_sunset (const SolunarDaySummary *self);
 
 extern KString *solunar_day_summary_to_json (const SolunarDaySummary *self);
 
+/** Get the time, in nanoseconds, that creating the summary spent on 
+    the sun calculations and on the moon calculations. */
+extern void solunar_day_summary_get_timings (const SolunarDaySummary *self,
+                 uint64_t *sun_ns, uint64_t *moon_ns);
+
+/** Write the summary as JSON, as UTF-8 and without building 
+    intermediate strings. With flags KJSONWRITER_NEWLINES the format is
+    the same as solunar_day_summary_to_json(); with flags 0 the 
+    summary is written on a single line. */
+extern void solunar_day_summary_write_json (const SolunarDaySummary *self,
+                 KJsonWriter *w, int flags);
+
 END_DECLS
 
@@ -17,13 +17,28 @@ typedef struct _SolunarYearSummary SolunarYearSummary;
 
 BEGIN_DECLS
 
+/** Get the festivals of the year. latitude only matters in that it 
+    selects the hemisphere, which decides which solstice is the summer
+    one. tz is the name of the zone in which dates are worked out and 
+    shown, or NULL for local time. */
 extern SolunarYearSummary *solunar_year_summary_create 
             (int year, double latitude, const char *tz);
 
+/** As solunar_year_summary_create, but with a zone object rather than 
+    a zone name. zone can be NULL, to use local time. The zone must 
+    outlive the summary -- zones from ktimezone_get() last for the 
+    lifetime of the program. */
+extern SolunarYearSummary *solunar_year_summary_create_in_zone
+            (int year, double latitude, const KTimeZone *zone);
+
 extern void solunar_year_summary_destroy (SolunarYearSummary *self);
 
 extern KString *solunar_year_summary_to_json 
             (const SolunarYearSummary *self);
+/** Write the list of festivals as JSON, in the same format as 
+    solunar_year_summary_to_json(). */
+extern void solunar_year_summary_write_json 
+            (const SolunarYearSummary *self, KJsonWriter *w);
 extern KString *solunar_year_summary_to_string 
             (const SolunarYearSummary *self);
 
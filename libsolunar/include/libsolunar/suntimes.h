@@ -23,8 +23,27 @@
 #define SUNTIMES_NAUTICAL_TWILIGHT (90 + 50.0/60.0 + 12)
 #define SUNTIMES_ASTRONOMICAL_TWILIGHT (90 + 50.0/60.0 + 18)
 
+/** Methods for finding the times of sunrise, sunset, and twilight. 
+ * APPROXIMATE works out the sun's position once, at a rough estimate
+ * of the time of the event, and gives the time to the minute 
+ * (truncated). PRECISE starts from the same estimate, then works out 
+ * the sun's position again at each improved estimate of the time,
+ * until the time is settled to the second. PRECISE takes several times
+ * as long. */
+typedef enum
+  {
+  SUNTIMES_APPROXIMATE = 0,
+  SUNTIMES_PRECISE = 1
+  } SunTimesSolver;
+
 BEGIN_DECLS
 
+/** Select the method used by get_sunrise(), get_sunset(), and 
+ * get_sun_events(). The default is SUNTIMES_APPROXIMATE. */
+extern void suntimes_set_solver (SunTimesSolver solver);
+
+extern SunTimesSolver suntimes_get_solver (void);
+
 /** Get a very approximate sunrise time, relative to midnight UTC at the
  * specified location on the specified day of year. Sunrise is taken to be 6AM
  * UTC at the meridian on that day. There's unlike to be a good reason to call
@@ -79,6 +98,17 @@ time_t suntimes_get_sunrise (time_t day, double latitude, double longitude,
 time_t suntimes_get_sunset (time_t day, double latitude, double longitude, 
        double zenith);
 
+/** Get the times of sunrise and sunset for each of n zeniths, on the 
+ * day which includes the specified time. The results are the same as 
+ * calling get_sunrise() and get_sunset() for each zenith in turn, but 
+ * the sun's position, which does not depend on the zenith, is worked 
+ * out only once for the morning and once for the evening. rises and
+ * sets receive n times each, and either can be NULL if it is not 
+ * wanted. A time is zero if the sun does not reach that zenith. */
+void suntimes_get_sun_events (time_t day, double latitude, 
+       double longitude, const double *zeniths, int n, time_t *rises,
+       time_t *sets);
+
 END_DECLS
 
 
@@ -2,14 +2,34 @@
 
 # Construct cityinfo.h from zone.tag
 # (c)2005-2012 Kevin Boone
+#
+# Usage: parse_zoneinfo.pl [zone.tab]
+#
+# As well as the table of cities, this writes a minimal perfect hash
+# of the case-folded names that can be looked up exactly: every full
+# zone name ("europe/london") and every last component ("london").
+# Each key is stored with the number of cities whose names contain it,
+# and the index of the first one, so that solcity.c can answer an
+# exact lookup without searching. Folding is the same as in solcity.c:
+# bit 5 of every byte is set.
+#
+# The hash is of the 'hash and displace' kind. Keys are first divided
+# into buckets by one hash; then, largest bucket first, each bucket is
+# given the smallest displacement d for which the hash with seed d puts
+# all of its keys into unused slots. The hash function here must match
+# solcity_hash() in solcity.c exactly.
 
 use strict;
 
-open IN,"</usr/share/zoneinfo/zone.tab" or die "Can't open zone.tab";
+my $zonetab = $ARGV[0] || "/usr/share/zoneinfo/zone.tab";
+
+open IN,"<$zonetab" or die "Can't open zone.tab";
 open OUT,">src/cityinfo.h" or die "Can't write cityinfo.h";
 print OUT "//Do not edit this file by hand\n";
 print OUT "static SolCity cities[] = {\n";
 
+my @names;
+
 while (my $line=<IN>)
   {
   chomp ($line);
@@ -47,8 +67,132 @@ while (my $line=<IN>)
   print OUT "\"$name\"";
   print OUT "},";
   print OUT "\n";
+  push @names, $name;
   }
 
 print OUT "{NULL, NULL, 0, 0}";
 print OUT "};\n";
 
+# Fold a name as solcity.c does
+sub fold
+  {
+  my $s = shift;
+  return join '', map { chr (ord ($_) | 32) } split //, $s;
+  }
+
+# 32-bit multiply, without overflowing Perl's integers
+sub mul32
+  {
+  my ($x, $y) = @_;
+  my $lo = $x * ($y & 0xffff);
+  my $hi = ($x * ($y >> 16)) & 0xffff;
+  return ($lo + ($hi << 16)) & 0xffffffff;
+  }
+
+# FNV-1a, with the seed mixed into the starting value, and a final
+# avalanche step
+sub hash
+  {
+  my ($s, $seed) = @_;
+  my $h = 2166136261 ^ mul32 ($seed, 0x9e3779b1);
+  foreach my $c (unpack ("C*", $s))
+    {
+    $h ^= $c;
+    $h = mul32 ($h, 16777619);
+    }
+  $h ^= $h >> 16;
+  $h = mul32 ($h, 0x85ebca6b);
+  $h ^= $h >> 13;
+  $h = mul32 ($h, 0xc2b2ae35);
+  $h ^= $h >> 16;
+  return $h;
+  }
+
+my @folded = map { fold ($_) } @names;
+my %seen;
+my @keys;
+foreach my $f (@folded)
+  {
+  my $leaf = $f;
+  $leaf =~ s/.*\///;
+  foreach my $k ($f, $leaf)
+    {
+    push @keys, $k unless $seen{$k}++;
+    }
+  }
+
+my $nkeys = scalar @keys;
+my $nbuckets = int (($nkeys + 3) / 4);
+
+my @buckets;
+foreach my $k (@keys)
+  {
+  push @{$buckets[hash ($k, 0) % $nbuckets]}, $k;
+  }
+
+my @slots;
+my @disp = (0) x $nbuckets;
+foreach my $bucket (sort { scalar (@{$buckets[$b] || []})
+          <=> scalar (@{$buckets[$a] || []}) || $a <=> $b }
+          0..$nbuckets-1)
+  {
+  my @bkeys = @{$buckets[$bucket] || []};
+  next unless @bkeys;
+  my $d = 1;
+  while (1)
+    {
+    my %used;
+    my $ok = 1;
+    foreach my $k (@bkeys)
+      {
+      my $slot = hash ($k, $d) % $nkeys;
+      if (defined $slots[$slot] || $used{$slot}++) { $ok = 0; last; }
+      }
+    last if $ok;
+    $d++;
+    die "Can't place bucket $bucket" if $d > 65535;
+    }
+  $disp[$bucket] = $d;
+  foreach my $k (@bkeys)
+    {
+    $slots[hash ($k, $d) % $nkeys] = $k;
+    }
+  }
+
+# Escape a folded name for a C string. Folding turns '_' into DEL
+sub cstring
+  {
+  my $s = shift;
+  return join '', map { my $c = ord ($_);
+      ($c < 32 || $c > 126 || $_ eq '"' || $_ eq '\\')
+        ? sprintf ("\\%03o", $c) : $_ } split //, $s;
+  }
+
+print OUT "\n";
+print OUT "#define CITY_HASH_KEYS $nkeys\n";
+print OUT "#define CITY_HASH_BUCKETS $nbuckets\n";
+print OUT "static const unsigned short city_hash_disp[] = {";
+for (my $i = 0; $i < $nbuckets; $i++)
+  {
+  print OUT "\n" if ($i % 16 == 0);
+  print OUT "$disp[$i],";
+  }
+print OUT "};\n";
+
+print OUT "static const CityHashEntry city_hash[] = {\n";
+foreach my $k (@slots)
+  {
+  my $count = 0;
+  my $first = -1;
+  for (my $i = 0; $i < scalar @folded; $i++)
+    {
+    if (index ($folded[$i], $k) >= 0)
+      {
+      $first = $i if $count == 0;
+      $count++;
+      }
+    }
+  print OUT "{\"" . cstring ($k) . "\",$count,$first},\n";
+  }
+print OUT "};\n";
+
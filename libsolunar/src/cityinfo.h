@@ -426,3 +426,873 @@ static SolCity cities[] = {
 {"Africa/Lusaka","ZM",-15.4166666666667,28.2833333333333,"Africa/Lusaka"},
 {"Africa/Harare","ZW",-17.8333333333333,31.05,"Africa/Harare"},
 {NULL, NULL, 0, 0}};
+
+#define CITY_HASH_KEYS 850
+#define CITY_HASH_BUCKETS 213
+static const unsigned short city_hash_disp[] = {
+12,2,19,9,19,26,54,160,1,20,9,96,1,8,30,552,
+9,2,13,2,2,28,95,29,12,1,3,49,1,2,38,3,
+72,26,2,33,118,59,5,38,30,2,7,16,3,23,1,16,
+25,22,9,4,8,48,15,55,9,161,3,16,102,6,12,7,
+119,31,40,9,127,1,16,197,1,117,23,47,25,2,3,56,
+80,9,21,49,63,260,3,88,132,149,1,112,56,31,2,1,
+7,1,5,95,17,62,1,8,289,202,42,159,127,108,155,550,
+264,87,104,44,15,306,766,4,1,70,470,167,43,605,20,42,
+4,176,763,160,6,873,517,2,27,415,10,333,67,1,387,40,
+6,586,68,14,4,1,560,399,1,273,654,7,380,284,64,317,
+10,748,739,46,45,1,57,75,139,7,1,335,105,176,14,66,
+8,85,3,67,51,5,478,93,1462,6,222,659,4,1384,741,13,
+1322,86,3,18,219,1581,3,36,1089,4043,44,302,587,3,3178,45,
+7,346,8,2296,2127,};
+static const CityHashEntry city_hash[] = {
+{"rio\177branco",1,77},
+{"beulah",1,395},
+{"america/menominee",1,392},
+{"asia/taipei",1,371},
+{"dumontdurville",1,11},
+{"malta",1,252},
+{"enderbury",1,207},
+{"vancouver",1,108},
+{"america/cancun",1,257},
+{"araguaina",1,66},
+{"manila",1,291},
+{"mazatlan",1,261},
+{"broken\177hill",1,38},
+{"kamchatka",1,333},
+{"sakhalin",1,331},
+{"istanbul",1,368},
+{"kolkata",1,193},
+{"america/nipigon",1,90},
+{"america/argentina/salta",1,20},
+{"budapest",1,185},
+{"kralendijk",1,61},
+{"windhoek",1,270},
+{"salta",1,20},
+{"port-au-prince",1,184},
+{"tell\177city",1,390},
+{"chisinau",1,235},
+{"libreville",1,159},
+{"europe/uzhgorod",1,374},
+{"nauru",1,279},
+{"christmas",1,130},
+{"indian/mauritius",1,253},
+{"asia/novosibirsk",1,319},
+{"america/marigot",1,237},
+{"pacific/guadalcanal",1,337},
+{"lisbon",1,299},
+{"copenhagen",1,137},
+{"america/argentina/san\177luis",1,27},
+{"montserrat",1,251},
+{"rio\177gallegos",1,28},
+{"cairo",1,144},
+{"africa/porto-novo",1,56},
+{"africa/conakry",1,172},
+{"samarkand",1,409},
+{"mayotte",1,421},
+{"america/tegucigalpa",1,182},
+{"africa/lome",1,360},
+{"africa/casablanca",1,233},
+{"jerusalem",1,191},
+{"america/rankin\177inlet",1,98},
+{"america/punta\177arenas",1,120},
+{"europe/luxembourg",1,230},
+{"america/whitehorse",1,109},
+{"america/indiana/vincennes",1,384},
+{"longyearbyen",1,344},
+{"asia/gaza",1,297},
+{"africa/brazzaville",1,115},
+{"asia/tomsk",1,321},
+{"pacific/apia",1,419},
+{"wake",1,378},
+{"america/resolute",1,97},
+{"mexico\177city",1,256},
+{"anchorage",1,400},
+{"america/puerto\177rico",1,296},
+{"asia/qostanay",1,217},
+{"africa/ceuta",1,148},
+{"antarctica/macquarie",1,33},
+{"st\177lucia",1,224},
+{"addis\177ababa",1,150},
+{"omsk",2,318},
+{"martinique",1,249},
+{"pacific/midway",1,377},
+{"pacific/nauru",1,279},
+{"grand\177turk",1,357},
+{"asia/kathmandu",1,278},
+{"america/monterrey",1,259},
+{"noumea",1,271},
+{"louisville",1,381},
+{"denver",1,396},
+{"america/dawson",2,106},
+{"asia/ho\177chi\177minh",1,416},
+{"tortola",1,414},
+{"monrovia",1,227},
+{"saratov",1,314},
+{"europe/vilnius",1,229},
+{"jayapura",1,189},
+{"chagos",1,194},
+{"brazzaville",1,115},
+{"damascus",1,355},
+{"stockholm",1,340},
+{"asia/kuwait",1,213},
+{"atikokan",1,94},
+{"fort\177nelson",1,107},
+{"africa/niamey",1,272},
+{"australia/currie",1,35},
+{"pacific/kosrae",1,156},
+{"bujumbura",1,55},
+{"adak",1,406},
+{"el\177aaiun",1,145},
+{"america/mazatlan",1,261},
+{"america/kralendijk",1,61},
+{"america/recife",1,65},
+{"dakar",1,348},
+{"chuuk",1,154},
+{"new\177york",1,379},
+{"los\177angeles",1,399},
+{"aqtobe",1,218},
+{"niamey",1,272},
+{"europe/berlin",1,134},
+{"europe/athens",1,175},
+{"kigali",1,335},
+{"africa/bujumbura",1,55},
+{"brussels",1,51},
+{"america/guatemala",1,177},
+{"kuala\177lumpur",1,267},
+{"abidjan",1,117},
+{"asia/kuching",1,268},
+{"iqaluit",1,92},
+{"st\177helena",1,342},
+{"ust-nera",1,329},
+{"zurich",1,116},
+{"asia/kuala\177lumpur",1,267},
+{"pacific/honolulu",1,407},
+{"shanghai",1,123},
+{"america/araguaina",1,66},
+{"america/curacao",1,129},
+{"chita",1,325},
+{"ojinaga",1,263},
+{"europe/podgorica",1,236},
+{"america/belem",1,63},
+{"pontianak",1,187},
+{"pacific/easter",1,121},
+{"singapore",1,341},
+{"africa/tripoli",1,232},
+{"america/sao\177paulo",1,69},
+{"america/ojinaga",1,263},
+{"creston",1,105},
+{"asia/aqtau",1,219},
+{"knox",1,391},
+{"dublin",1,190},
+{"minsk",1,81},
+{"vientiane",1,222},
+{"mcmurdo",1,8},
+{"beirut",1,223},
+{"glace\177bay",1,85},
+{"panama",1,284},
+{"antarctica/davis",1,10},
+{"monaco",1,234},
+{"toronto",1,89},
+{"africa/bissau",1,179},
+{"europe/brussels",1,51},
+{"kwajalein",1,240},
+{"barbados",1,49},
+{"america/argentina/tucuman",1,22},
+{"paramaribo",1,350},
+{"kabul",1,2},
+{"asuncion",1,303},
+{"atlantic/madeira",1,300},
+{"dhaka",1,50},
+{"asia/brunei",1,59},
+{"america/argentina/ushuaia",1,29},
+{"asia/karachi",1,292},
+{"apia",1,419},
+{"uzhgorod",1,374},
+{"adelaide",1,41},
+{"america/montevideo",1,408},
+{"thunder\177bay",1,91},
+{"europe/rome",1,198},
+{"america/porto\177velho",1,73},
+{"anadyr",1,334},
+{"sao\177tome",1,352},
+{"asia/makassar",1,188},
+{"pacific/fakaofo",1,363},
+{"africa/kigali",1,335},
+{"la\177paz",1,60},
+{"europe/tallinn",1,143},
+{"indian/kerguelen",1,359},
+{"america/inuvik",1,104},
+{"asia/vladivostok",1,328},
+{"america/santo\177domingo",1,139},
+{"novokuznetsk",1,322},
+{"tirane",1,5},
+{"europe/london",1,160},
+{"vatican",1,411},
+{"antarctica/vostok",1,17},
+{"dawson\177creek",1,106},
+{"davis",1,10},
+{"antigua",1,3},
+{"comoro",1,209},
+{"asia/hebron",1,298},
+{"qatar",1,304},
+{"america/panama",1,284},
+{"asia/riyadh",1,336},
+{"sao\177paulo",1,69},
+{"pacific/efate",1,417},
+{"port\177moresby",1,289},
+{"america/el\177salvador",1,353},
+{"ho\177chi\177minh",1,416},
+{"antarctica/casey",1,9},
+{"america/argentina/buenos\177aires",1,18},
+{"thule",1,170},
+{"pacific/tongatapu",1,367},
+{"buenos\177aires",1,18},
+{"asia/dili",1,364},
+{"asia/anadyr",1,334},
+{"africa/harare",1,424},
+{"europe/zagreb",1,183},
+{"conakry",1,172},
+{"casablanca",1,233},
+{"kinshasa",1,112},
+{"kuwait",1,213},
+{"africa/bamako",1,242},
+{"indian/antananarivo",1,238},
+{"africa/lubumbashi",1,113},
+{"samara",1,316},
+{"africa/juba",1,351},
+{"america/vancouver",1,108},
+{"atlantic/azores",1,301},
+{"asia/tbilisi",1,162},
+{"sarajevo",1,48},
+{"america/argentina/catamarca",1,23},
+{"america/indiana/knox",1,391},
+{"lagos",1,274},
+{"funafuti",1,370},
+{"asia/yangon",1,243},
+{"asia/jayapura",1,189},
+{"muscat",1,283},
+{"atlantic/reykjavik",1,197},
+{"baku",1,47},
+{"america/grand\177turk",1,357},
+{"jujuy",1,21},
+{"pacific/chatham",1,282},
+{"america/north\177dakota/new\177salem",1,394},
+{"novosibirsk",1,319},
+{"america/cambridge\177bay",1,102},
+{"winnipeg",1,95},
+{"belgrade",1,307},
+{"asmara",1,146},
+{"europe/malta",1,252},
+{"africa/monrovia",1,227},
+{"indian/mayotte",1,421},
+{"europe/budapest",1,185},
+{"troll",1,16},
+{"santo\177domingo",1,139},
+{"phoenix",1,398},
+{"asia/aden",1,420},
+{"america/st\177barthelemy",1,57},
+{"arctic/longyearbyen",1,344},
+{"europe/volgograd",1,313},
+{"america/nome",1,405},
+{"europe/tirane",1,5},
+{"warsaw",1,293},
+{"kaliningrad",1,308},
+{"australia/melbourne",1,36},
+{"europe/belgrade",1,307},
+{"godthab",1,167},
+{"africa/el\177aaiun",1,145},
+{"gaborone",1,80},
+{"irkutsk",1,324},
+{"bogota",1,125},
+{"qostanay",1,217},
+{"australia/broken\177hill",1,38},
+{"europe/kaliningrad",1,308},
+{"asia/yekaterinburg",1,317},
+{"kampala",1,376},
+{"gaza",1,297},
+{"cape\177verde",1,128},
+{"bermuda",1,58},
+{"asia/bahrain",1,54},
+{"america/caracas",1,413},
+{"easter",1,121},
+{"europe/dublin",1,190},
+{"europe/sofia",1,53},
+{"reykjavik",1,197},
+{"johannesburg",1,422},
+{"darwin",1,42},
+{"djibouti",1,136},
+{"bishkek",1,204},
+{"tucuman",1,22},
+{"europe/gibraltar",1,166},
+{"belize",1,82},
+{"yellowknife",1,103},
+{"dawson",2,106},
+{"chihuahua",1,262},
+{"america/chicago",1,389},
+{"asia/hovd",1,245},
+{"nairobi",1,203},
+{"bahrain",1,54},
+{"la\177rioja",1,24},
+{"africa/dar\177es\177salaam",1,372},
+{"dili",1,364},
+{"antananarivo",1,238},
+{"menominee",1,392},
+{"america/atikokan",1,94},
+{"america/glace\177bay",1,85},
+{"pacific/gambier",1,288},
+{"rarotonga",1,118},
+{"pacific/port\177moresby",1,289},
+{"australia/lindeman",1,40},
+{"andorra",1,0},
+{"simferopol",1,310},
+{"vladivostok",1,328},
+{"africa/douala",1,122},
+{"bucharest",1,306},
+{"madrid",1,147},
+{"ndjamena",1,358},
+{"america/st\177thomas",1,415},
+{"asia/almaty",1,215},
+{"america/paramaribo",1,350},
+{"america/argentina/cordoba",1,19},
+{"america/indiana/tell\177city",1,390},
+{"porto\177velho",1,73},
+{"australia/adelaide",1,41},
+{"yakutat",1,404},
+{"luanda",1,7},
+{"america/indiana/marengo",1,386},
+{"pacific/fiji",1,152},
+{"asia/dhaka",1,50},
+{"asia/bangkok",1,361},
+{"atlantic/st\177helena",1,342},
+{"america/tortola",1,414},
+{"asia/yakutsk",1,326},
+{"africa/blantyre",1,255},
+{"mendoza",1,26},
+{"america/danmarkshavn",1,168},
+{"tbilisi",1,162},
+{"tehran",1,196},
+{"america/bahia\177banderas",1,266},
+{"whitehorse",1,109},
+{"america/los\177angeles",1,399},
+{"asia/jerusalem",1,191},
+{"puerto\177rico",1,296},
+{"america/sitka",1,402},
+{"europe/oslo",1,277},
+{"america/merida",1,258},
+{"america/managua",1,275},
+{"st\177vincent",1,412},
+{"curacao",1,129},
+{"nipigon",1,90},
+{"new\177salem",1,394},
+{"tongatapu",1,367},
+{"dominica",1,138},
+{"tokyo",1,202},
+{"america/lima",1,285},
+{"niue",1,280},
+{"europe/riga",1,231},
+{"macquarie",1,33},
+{"asia/tashkent",1,410},
+{"europe/zurich",1,116},
+{"center",1,393},
+{"asia/hong\177kong",1,181},
+{"europe/sarajevo",1,48},
+{"taipei",1,371},
+{"marquesas",1,287},
+{"asia/yerevan",1,6},
+{"st\177johns",1,83},
+{"europe/vaduz",1,225},
+{"europe/amsterdam",1,276},
+{"australia/darwin",1,42},
+{"san\177juan",1,25},
+{"antarctica/palmer",1,13},
+{"monterrey",1,259},
+{"europe/lisbon",1,299},
+{"asia/kamchatka",1,333},
+{"africa/abidjan",1,117},
+{"america/indiana/petersburg",1,387},
+{"america/eirunepe",1,76},
+{"rainy\177river",1,96},
+{"atlantic/canary",1,149},
+{"hong\177kong",1,181},
+{"pacific/pago\177pago",1,30},
+{"kiritimati",1,208},
+{"vienna",1,31},
+{"lord\177howe",1,32},
+{"mawson",1,12},
+{"pacific/rarotonga",1,118},
+{"punta\177arenas",1,120},
+{"america/argentina/rio\177gallegos",1,28},
+{"lima",1,285},
+{"america/argentina/mendoza",1,26},
+{"africa/addis\177ababa",1,150},
+{"dar\177es\177salaam",1,372},
+{"africa/cairo",1,144},
+{"pacific/wallis",1,418},
+{"zagreb",1,183},
+{"eucla",1,44},
+{"bahia\177banderas",1,266},
+{"asia/bishkek",1,204},
+{"america/toronto",1,89},
+{"america/guayaquil",1,141},
+{"pangnirtung",1,93},
+{"asia/kolkata",1,193},
+{"africa/gaborone",1,80},
+{"australia/perth",1,43},
+{"cambridge\177bay",1,102},
+{"famagusta",1,132},
+{"kathmandu",1,278},
+{"america/antigua",1,3},
+{"asia/thimphu",1,79},
+{"canary",1,149},
+{"nassau",1,78},
+{"ulyanovsk",1,315},
+{"america/phoenix",1,398},
+{"faroe",1,157},
+{"jakarta",1,186},
+{"america/thule",1,170},
+{"america/belize",1,82},
+{"pitcairn",1,295},
+{"america/kentucky/monticello",1,382},
+{"africa/banjul",1,171},
+{"guayaquil",1,141},
+{"europe/san\177marino",1,347},
+{"america/martinique",1,249},
+{"colombo",1,226},
+{"asia/baku",1,47},
+{"asia/atyrau",1,220},
+{"america/hermosillo",1,264},
+{"jersey",1,199},
+{"africa/maputo",1,269},
+{"athens",1,175},
+{"indian/mahe",1,338},
+{"oslo",1,277},
+{"america/argentina/la\177rioja",1,24},
+{"america/halifax",1,84},
+{"vaduz",1,225},
+{"wallis",1,418},
+{"america/jamaica",1,200},
+{"algiers",1,140},
+{"juneau",1,401},
+{"europe/bucharest",1,306},
+{"brunei",1,59},
+{"danmarkshavn",1,168},
+{"gambier",1,288},
+{"tripoli",1,232},
+{"asia/sakhalin",1,331},
+{"mahe",1,338},
+{"africa/dakar",1,348},
+{"berlin",1,134},
+{"douala",1,122},
+{"asia/qatar",1,304},
+{"indian/comoro",1,209},
+{"st\177kitts",1,210},
+{"freetown",1,346},
+{"pacific/guam",1,178},
+{"africa/ndjamena",1,358},
+{"port\177of\177spain",1,369},
+{"manaus",1,75},
+{"almaty",1,215},
+{"europe/istanbul",1,368},
+{"europe/zaporozhye",1,375},
+{"antarctica/rothera",1,14},
+{"nicosia",1,131},
+{"europe/stockholm",1,340},
+{"bahia",2,68},
+{"ulaanbaatar",1,244},
+{"america/st\177kitts",1,210},
+{"miquelon",1,294},
+{"syowa",1,15},
+{"pacific/majuro",1,239},
+{"america/montserrat",1,251},
+{"america/argentina/san\177juan",1,25},
+{"europe/skopje",1,241},
+{"antarctica/troll",1,16},
+{"honolulu",1,407},
+{"auckland",1,281},
+{"madeira",1,300},
+{"asia/kabul",1,2},
+{"khandyga",1,327},
+{"america/creston",1,105},
+{"hovd",1,245},
+{"america/grenada",1,161},
+{"america/st\177johns",1,83},
+{"asia/macau",1,247},
+{"asia/damascus",1,355},
+{"lower\177princes",1,354},
+{"barnaul",1,320},
+{"indian/reunion",1,305},
+{"monticello",1,382},
+{"atyrau",1,220},
+{"america/rainy\177river",1,96},
+{"america/maceio",1,67},
+{"tarawa",1,206},
+{"america/metlakatla",1,403},
+{"europe/madrid",1,147},
+{"san\177luis",1,27},
+{"metlakatla",1,403},
+{"stanley",1,153},
+{"asia/oral",1,221},
+{"asia/barnaul",1,320},
+{"america/pangnirtung",1,93},
+{"ushuaia",1,29},
+{"rothera",1,14},
+{"grenada",1,161},
+{"noronha",1,62},
+{"santarem",1,72},
+{"eirunepe",1,76},
+{"nouakchott",1,250},
+{"asia/ashgabat",1,365},
+{"africa/bangui",1,114},
+{"pacific/chuuk",1,154},
+{"swift\177current",1,100},
+{"isle\177of\177man",1,192},
+{"riga",1,231},
+{"australia/eucla",1,44},
+{"asia/colombo",1,226},
+{"europe/chisinau",1,235},
+{"america/cuiaba",1,71},
+{"qyzylorda",1,216},
+{"tomsk",1,321},
+{"cocos",1,111},
+{"pacific/saipan",1,248},
+{"mbabane",1,356},
+{"asia/pyongyang",1,211},
+{"krasnoyarsk",1,323},
+{"bratislava",1,345},
+{"america/indiana/vevay",1,388},
+{"europe/astrakhan",1,312},
+{"america/miquelon",1,294},
+{"paris",1,158},
+{"vincennes",1,384},
+{"america/regina",1,99},
+{"maceio",1,67},
+{"bangui",1,114},
+{"seoul",1,212},
+{"mogadishu",1,349},
+{"europe/prague",1,133},
+{"africa/windhoek",1,270},
+{"australia/sydney",1,37},
+{"asia/ust-nera",1,329},
+{"palmer",1,13},
+{"america/mexico\177city",1,256},
+{"gibraltar",1,166},
+{"pacific/norfolk",1,273},
+{"lusaka",1,423},
+{"st\177barthelemy",1,57},
+{"america/adak",1,406},
+{"europe/copenhagen",1,137},
+{"asia/dushanbe",1,362},
+{"galapagos",1,142},
+{"san\177marino",1,347},
+{"blanc-sablon",1,88},
+{"havana",1,127},
+{"australia/lord\177howe",1,32},
+{"goose\177bay",1,87},
+{"belem",1,63},
+{"pacific/funafuti",1,370},
+{"america/campo\177grande",1,70},
+{"marengo",1,386},
+{"rankin\177inlet",1,98},
+{"atlantic/bermuda",1,58},
+{"regina",1,99},
+{"tahiti",1,286},
+{"america/havana",1,127},
+{"america/denver",1,396},
+{"malabo",1,174},
+{"norfolk",1,273},
+{"america/anchorage",1,400},
+{"guadalcanal",1,337},
+{"pacific/niue",1,280},
+{"america/cayenne",1,163},
+{"tegucigalpa",1,182},
+{"melbourne",1,36},
+{"africa/freetown",1,346},
+{"america/manaus",1,75},
+{"makassar",1,188},
+{"choibalsan",1,246},
+{"catamarca",1,23},
+{"asia/tokyo",1,202},
+{"asia/magadan",1,330},
+{"amman",1,201},
+{"america/blanc-sablon",1,88},
+{"africa/khartoum",1,339},
+{"azores",1,301},
+{"efate",1,417},
+{"europe/andorra",1,0},
+{"fakaofo",1,363},
+{"asia/beirut",1,223},
+{"europe/monaco",1,234},
+{"america/st\177lucia",1,224},
+{"europe/saratov",1,314},
+{"karachi",1,292},
+{"pacific/pitcairn",1,295},
+{"guam",1,178},
+{"atlantic/cape\177verde",1,128},
+{"america/asuncion",1,303},
+{"lubumbashi",1,113},
+{"baghdad",1,195},
+{"santiago",1,119},
+{"america/guadeloupe",1,173},
+{"harare",1,424},
+{"oral",1,221},
+{"america/godthab",1,167},
+{"palau",1,302},
+{"america/boa\177vista",1,74},
+{"america/nassau",1,78},
+{"pacific/tahiti",1,286},
+{"asia/omsk",1,318},
+{"anguilla",1,4},
+{"chatham",1,282},
+{"asia/shanghai",1,123},
+{"tijuana",1,265},
+{"maputo",1,269},
+{"asia/urumqi",1,124},
+{"vevay",1,388},
+{"bissau",1,179},
+{"pacific/galapagos",1,142},
+{"tallinn",1,143},
+{"reunion",1,305},
+{"america/port\177of\177spain",1,369},
+{"marigot",1,237},
+{"recife",1,65},
+{"america/moncton",1,86},
+{"casey",1,9},
+{"asia/muscat",1,283},
+{"america/thunder\177bay",1,91},
+{"helsinki",1,151},
+{"amsterdam",1,276},
+{"bangkok",1,361},
+{"america/edmonton",1,101},
+{"resolute",1,97},
+{"volgograd",1,313},
+{"detroit",1,380},
+{"america/santiago",1,119},
+{"vostok",2,17},
+{"asia/famagusta",1,132},
+{"africa/tunis",1,366},
+{"mauritius",1,253},
+{"accra",1,165},
+{"africa/ouagadougou",1,52},
+{"europe/samara",1,316},
+{"america/juneau",1,401},
+{"america/lower\177princes",1,354},
+{"currie",1,35},
+{"kirov",1,311},
+{"sydney",1,37},
+{"kosrae",1,156},
+{"america/bahia",2,68},
+{"america/anguilla",1,4},
+{"london",1,160},
+{"moscow",1,309},
+{"aruba",1,45},
+{"america/detroit",1,380},
+{"asia/seoul",1,212},
+{"asia/amman",1,201},
+{"america/new\177york",1,379},
+{"sofia",1,53},
+{"st\177thomas",1,415},
+{"asia/choibalsan",1,246},
+{"ouagadougou",1,52},
+{"sitka",1,402},
+{"cayenne",1,163},
+{"america/scoresbysund",1,169},
+{"indian/maldives",1,254},
+{"inuvik",1,104},
+{"boa\177vista",1,74},
+{"europe/kirov",1,311},
+{"europe/helsinki",1,151},
+{"hebron",1,298},
+{"pohnpei",1,155},
+{"america/la\177paz",1,60},
+{"el\177salvador",1,353},
+{"scoresbysund",1,169},
+{"asia/ulaanbaatar",1,244},
+{"africa/sao\177tome",1,352},
+{"america/rio\177branco",1,77},
+{"america/winnipeg",1,95},
+{"antarctica/dumontdurville",1,11},
+{"cayman",1,214},
+{"tunis",1,366},
+{"fortaleza",1,64},
+{"ljubljana",1,343},
+{"prague",1,133},
+{"pacific/noumea",1,271},
+{"luxembourg",1,230},
+{"macau",1,247},
+{"america/st\177vincent",1,412},
+{"banjul",1,171},
+{"africa/libreville",1,159},
+{"vilnius",1,229},
+{"america/cayman",1,214},
+{"yekaterinburg",1,317},
+{"asia/khandyga",1,327},
+{"africa/algiers",1,140},
+{"africa/kampala",1,376},
+{"pyongyang",1,211},
+{"lindeman",1,40},
+{"busingen",1,135},
+{"europe/mariehamn",1,46},
+{"america/chihuahua",1,262},
+{"australia/brisbane",1,39},
+{"pacific/enderbury",1,207},
+{"asia/novokuznetsk",1,322},
+{"asia/vientiane",1,222},
+{"aqtau",1,219},
+{"hobart",1,34},
+{"america/swift\177current",1,100},
+{"pacific/kiritimati",1,208},
+{"merida",1,258},
+{"america/yakutat",1,404},
+{"antarctica/mcmurdo",1,8},
+{"europe/warsaw",1,293},
+{"africa/maseru",1,228},
+{"guatemala",1,177},
+{"asia/manila",1,291},
+{"america/noronha",1,62},
+{"skopje",1,241},
+{"aden",1,420},
+{"podgorica",1,236},
+{"america/kentucky/louisville",1,381},
+{"europe/guernsey",1,164},
+{"pacific/wake",1,378},
+{"atlantic/south\177georgia",1,176},
+{"africa/djibouti",1,136},
+{"matamoros",1,260},
+{"juba",1,351},
+{"america/bogota",1,125},
+{"europe/paris",1,158},
+{"srednekolymsk",1,332},
+{"australia/hobart",1,34},
+{"america/indiana/indianapolis",1,383},
+{"asia/nicosia",1,131},
+{"campo\177grande",1,70},
+{"bamako",1,242},
+{"atlantic/faroe",1,157},
+{"asia/jakarta",1,186},
+{"perth",1,43},
+{"cuiaba",1,71},
+{"europe/vatican",1,411},
+{"magadan",1,330},
+{"pacific/pohnpei",1,155},
+{"yakutsk",1,326},
+{"petersburg",1,387},
+{"africa/mogadishu",1,349},
+{"africa/johannesburg",1,422},
+{"rome",1,198},
+{"majuro",1,239},
+{"managua",1,275},
+{"america/yellowknife",1,103},
+{"tashkent",1,410},
+{"montevideo",1,408},
+{"cordoba",1,19},
+{"asia/srednekolymsk",1,332},
+{"blantyre",1,255},
+{"africa/asmara",1,146},
+{"zaporozhye",1,375},
+{"halifax",1,84},
+{"bougainville",1,290},
+{"riyadh",1,336},
+{"america/argentina/jujuy",1,21},
+{"america/dominica",1,138},
+{"thimphu",1,79},
+{"indian/cocos",1,111},
+{"pago\177pago",1,30},
+{"caracas",1,413},
+{"asia/singapore",1,341},
+{"europe/busingen",1,135},
+{"boise",1,397},
+{"dushanbe",1,362},
+{"phnom\177penh",1,205},
+{"saipan",1,248},
+{"jamaica",1,200},
+{"america/guyana",1,180},
+{"astrakhan",1,312},
+{"pacific/bougainville",1,290},
+{"asia/qyzylorda",1,216},
+{"nome",1,405},
+{"america/north\177dakota/center",1,393},
+{"asia/dubai",1,1},
+{"urumqi",1,124},
+{"america/north\177dakota/beulah",1,395},
+{"dubai",1,1},
+{"ashgabat",1,365},
+{"america/indiana/winamac",1,385},
+{"cancun",1,257},
+{"antarctica/syowa",1,15},
+{"america/tijuana",1,265},
+{"mariehamn",1,46},
+{"pacific/kwajalein",1,240},
+{"africa/accra",1,165},
+{"africa/mbabane",1,356},
+{"pacific/auckland",1,281},
+{"atlantic/stanley",1,153},
+{"africa/lagos",1,274},
+{"america/iqaluit",1,92},
+{"asia/irkutsk",1,324},
+{"america/matamoros",1,260},
+{"pacific/marquesas",1,287},
+{"africa/nouakchott",1,250},
+{"midway",1,377},
+{"asia/aqtobe",1,218},
+{"edmonton",1,101},
+{"lome",1,360},
+{"hermosillo",1,264},
+{"europe/jersey",1,199},
+{"yangon",1,243},
+{"moncton",1,86},
+{"kerguelen",1,359},
+{"asia/krasnoyarsk",1,323},
+{"ceuta",1,148},
+{"costa\177rica",1,126},
+{"south\177georgia",1,176},
+{"yerevan",1,6},
+{"chicago",1,389},
+{"america/santarem",1,72},
+{"america/dawson\177creek",1,106},
+{"maseru",1,228},
+{"africa/luanda",1,7},
+{"africa/nairobi",1,203},
+{"asia/pontianak",1,187},
+{"europe/kiev",1,373},
+{"europe/vienna",1,31},
+{"antarctica/mawson",1,12},
+{"guadeloupe",1,173},
+{"america/goose\177bay",1,87},
+{"europe/ljubljana",1,343},
+{"america/fort\177nelson",1,107},
+{"porto-novo",1,56},
+{"europe/minsk",1,81},
+{"pacific/tarawa",1,206},
+{"asia/tehran",1,196},
+{"indianapolis",1,383},
+{"asia/baghdad",1,195},
+{"indian/christmas",1,130},
+{"brisbane",1,39},
+{"america/port-au-prince",1,184},
+{"europe/ulyanovsk",1,315},
+{"guyana",1,180},
+{"europe/moscow",1,309},
+{"africa/lusaka",1,423},
+{"america/fortaleza",1,64},
+{"winamac",1,385},
+{"asia/chita",1,325},
+{"kiev",1,373},
+{"africa/kinshasa",1,112},
+{"indian/chagos",1,194},
+{"khartoum",1,339},
+{"america/aruba",1,45},
+{"kuching",1,268},
+{"america/barbados",1,49},
+{"maldives",1,254},
+{"asia/samarkand",1,409},
+{"africa/malabo",1,174},
+{"america/costa\177rica",1,126},
+{"europe/bratislava",1,345},
+{"pacific/palau",1,302},
+{"asia/phnom\177penh",1,205},
+{"america/boise",1,397},
+{"europe/isle\177of\177man",1,192},
+{"europe/simferopol",1,310},
+{"fiji",1,152},
+{"guernsey",1,164},
+};
@@ -14,16 +14,49 @@
 #include <assert.h>
 #include <errno.h>
 #include <string.h>
+#include <math.h>
+#include <pthread.h>
 #include <klib/klib.h>
 #include <libsolunar/festival.h>
 
 #define KLOG_CLASS "solunar.festival"
 
-static const int SECS_PER_DAY = 24 * 3600;
+static const double TWO_PI = 2.0 * M_PI; 
 
-double periodic24 (double t); //FWD
-static char *getenv_dup (const char *env); //FWD
-static void my_setenv (const char *name, const char *value, BOOL dummy);
+// The number of years worked out together, in festival_compute_seasons
+#define SEASONS_CHUNK 64
+
+// The range of years whose seasonal events are kept in a table
+#define SEASONS_TABLE_FIRST 1900
+#define SEASONS_TABLE_LAST 2200
+#define SEASONS_TABLE_YEARS (SEASONS_TABLE_LAST - SEASONS_TABLE_FIRST + 1)
+
+/* Coefficients of the polynomials in m = (year - 2000) / 1000 that give 
+   the mean times of the equinoxes and solstices, as Julian days, for 
+   the years 1000-3000 (Meeus, table 27.B), in FestivalSeason order. */
+static const double season_poly[FESTIVAL_NUM_SEASONS][5] =
+  {
+  {2451623.80984, 365242.37404, 0.05169, -0.00411, -0.00057},
+  {2451716.56767, 365241.62603, 0.00325, 0.00888, -0.00030},
+  {2451810.21715, 365242.01767, -0.11575, 0.00337, 0.00078},
+  {2451900.05952, 365242.74049, -0.06223, -0.00823, 0.00032}
+  };
+
+/* Meeus' 24 periodic terms (table 27.C): A cos (B + C T), in degrees */
+static const double periodic_a[24] = {485,203,199,182,156,136,77,74,70,58,
+      52,50,45,44,29,18,17,16,14,12,12,12,9,8};
+static const double periodic_b[24] = {324.96,337.23,342.08,27.85,73.14,
+      171.52,222.54,296.72,243.58,119.81,297.17,21.02, 247.54,
+      325.15,60.93,155.12,288.79,198.04,199.76,95.39,287.11,
+      320.81,227.73,15.45};
+static const double periodic_c[24] = {1934.136,32964.467,20.186,445267.112,
+      45036.886,22518.443, 65928.934,3034.906,9037.513,33718.147,
+      150.678,2281.226, 29929.562,31555.956,4443.417,67555.328,
+      4562.452,62894.029, 31436.921,14577.848,31931.756,34777.259,
+      1222.114,16859.074};
+
+static time_t seasons_table[FESTIVAL_NUM_SEASONS][SEASONS_TABLE_YEARS];
+static pthread_once_t seasons_table_once = PTHREAD_ONCE_INIT;
 
 /*============================================================================
   
@@ -54,6 +87,68 @@ Festival *festival_new (time_t date, BOOL has_time, const char *name)
   return self;
   }
 
+/*============================================================================
+  
+  festival_get_easter_date
+
+  Get the month (1-12) and day of Easter Sunday in the Gregorian 
+  calendar, by the anonymous Gregorian algorithm
+
+  ==========================================================================*/
+static void festival_get_easter_date (int year, int *month, int *day)
+  {
+  KLOG_IN
+  int n_year = year;
+  int nA = n_year % 19;
+  int nB = n_year / 100;
+  int nC = n_year % 100;
+  int nD = nB / 4;
+  int nE = nB % 4;
+  int nF = (nB + 8) / 25;
+  int nG = (nB - nF + 1) / 3;
+  int nH = (19 * nA + nB - nD - nG + 15) % 30;
+  int nI = nC / 4;
+  int nK = nC % 4;
+  int nL = (32 + 2 * nE + 2 * nI - nH - nK) % 7;
+  int nM = (nA + 11 * nH + 22 * nL) / 451;
+  *month = (nH + nL - 7 * nM + 114) / 31;
+  *day = (nH + nL - 7 * nM + 114) % 31 + 1;
+  KLOG_OUT
+  }
+
+/*============================================================================
+  
+  festival_from_easter
+
+  Create the festival that falls the specified number of days after
+  (or, if negative, before) Easter Sunday. Its time is 02:00 local 
+  time in the zone, or in the zone of the process if zone is NULL. 
+  The offset is applied to the calendar date, before conversion, so 
+  the time of day is the same whether or not daylight saving starts
+  or ends in between.
+
+  ==========================================================================*/
+static Festival *festival_from_easter (int year, int offset, 
+         const char *name, const KTimeZone *zone)
+  {
+  KLOG_IN
+  int month, day;
+  festival_get_easter_date (year, &month, &day);
+  // The day of the month can be out of range, even negative; the
+  //  conversion normalizes it
+  struct tm tm;
+  memset (&tm, 0, sizeof (tm));
+  tm.tm_year = year - 1900;
+  tm.tm_mon = month - 1;
+  tm.tm_mday = day + offset;
+  tm.tm_hour = 2;
+  tm.tm_isdst = -1;
+  time_t t = zone ? ktimezone_local_to_utc (zone, &tm) : mktime (&tm);
+  Festival *ret = festival_new (t, FALSE, name);
+  KLOG_OUT
+  return ret;
+  }
+
 /*============================================================================
   
   festival_destroy
@@ -72,25 +167,141 @@ void festival_destroy (Festival *self)
 
 /*============================================================================
   
-  festival_get_autumnal_equinox
+  festival_compute_seasons
+
+  Work out one seasonal event for n consecutive years, by Meeus' method
+  (chapter 27): a polynomial gives the mean time of the event, and 24
+  periodic terms correct it. The years are worked out in chunks, each 
+  step for the whole chunk before the next, so that every loop runs
+  over contiguous arrays with no dependence between iterations. The 
+  compiler vectorises the arithmetic; the cosines, which dominate, 
+  remain scalar calls to the C library. The arithmetic is exactly that
+  of working out one year at a time, term for term, so the results are
+  identical either way.
 
   ==========================================================================*/
-Festival *festival_get_autumnal_equinox (int year)
+static void festival_compute_seasons (int first_year, int n, 
+         FestivalSeason season, time_t *out)
+  {
+  KLOG_IN
+  const double *p = season_poly[season];
+  for (int base = 0; base < n; base += SEASONS_CHUNK)
+    {
+    int len = n - base < SEASONS_CHUNK ? n - base : SEASONS_CHUNK;
+    double jde[SEASONS_CHUNK];
+    double t[SEASONS_CHUNK];
+    double s[SEASONS_CHUNK];
+
+    for (int j = 0; j < len; j++)
+      {
+      double m = (first_year + base + j - 2000.0) / 1000.0;
+      jde[j] = p[0] + p[1] * m + p[2] * m * m + p[3] * m * m * m 
+        + p[4] * m * m * m * m;
+      t[j] = (jde[j] - 2451545.0) / 36525.0;
+      s[j] = 0.0;
+      }
+
+    for (int i = 0; i < 24; i++)
+      {
+      double a = periodic_a[i], b = periodic_b[i], c = periodic_c[i];
+      for (int j = 0; j < len; j++)
+        s[j] += a * cos ((b + c * t[j]) / 360.0 * TWO_PI);
+      }
+
+    for (int j = 0; j < len; j++)
+      {
+      double w = 35999.373 * t[j] - 2.47;
+      double dL = 1 + 0.0334 * cos (w / 360.0 * TWO_PI) 
+        + 0.0007 * cos (2 * w / 360.0 * TWO_PI);
+      out[base + j] = datetimeconv_jd_to_time 
+        (jde[j] + ((0.00001 * s[j]) / dL));
+      }
+    }
+  KLOG_OUT
+  }
+
+/*============================================================================
+  
+  festival_init_seasons_table
+
+  ==========================================================================*/
+static void festival_init_seasons_table (void)
   {
   KLOG_IN
+  for (int e = 0; e < FESTIVAL_NUM_SEASONS; e++)
+    festival_compute_seasons (SEASONS_TABLE_FIRST, SEASONS_TABLE_YEARS, 
+      e, seasons_table[e]);
+  KLOG_OUT
+  }
 
-  double m = (year - 2000.0) / 1000.0;
-  double ae = 2451810.21715 + 365242.01767 * m - 0.11575 * m
-      * m + 0.00337 * m * m * m + 0.00078 * m * m * m * m ;
-  double t = (ae - 2451545.0) / 36525.0;
-  double w = 35999.373*t - 2.47;
-  double dL = 1 + 0.0334*mathutil_cos_deg(w) + 0.0007*mathutil_cos_deg(2*w);
-  double s =periodic24 (t);
-  ae = ae + ((0.00001*s) / dL);
+/*============================================================================
+  
+  festival_get_seasons
+
+  ==========================================================================*/
+void festival_get_seasons (int first_year, int nyears, 
+         time_t *seasons[FESTIVAL_NUM_SEASONS])
+  {
+  KLOG_IN
+  pthread_once (&seasons_table_once, festival_init_seasons_table);
+
+  // The years are in up to three runs: before the table, in it, and
+  //  after it
+  int last_year = first_year + nyears - 1;
+  int tfirst = first_year > SEASONS_TABLE_FIRST 
+    ? first_year : SEASONS_TABLE_FIRST;
+  int tlast = last_year < SEASONS_TABLE_LAST ? last_year : SEASONS_TABLE_LAST;
+  for (int e = 0; e < FESTIVAL_NUM_SEASONS; e++)
+    {
+    time_t *out = seasons[e];
+    if (!out) continue;
+    if (tfirst <= tlast)
+      {
+      if (first_year < tfirst)
+        festival_compute_seasons (first_year, tfirst - first_year, e, out);
+      memcpy (out + (tfirst - first_year), 
+        seasons_table[e] + (tfirst - SEASONS_TABLE_FIRST), 
+        (tlast - tfirst + 1) * sizeof (time_t));
+      if (last_year > tlast)
+        festival_compute_seasons (tlast + 1, last_year - tlast, e, 
+          out + (tlast + 1 - first_year));
+      }
+    else
+      festival_compute_seasons (first_year, nyears, e, out);
+    }
+  KLOG_OUT
+  }
+
+/*============================================================================
+  
+  festival_get_season
+
+  ==========================================================================*/
+time_t festival_get_season (int year, FestivalSeason season)
+  {
+  KLOG_IN
+  time_t ret;
+  if (year >= SEASONS_TABLE_FIRST && year <= SEASONS_TABLE_LAST)
+    {
+    pthread_once (&seasons_table_once, festival_init_seasons_table);
+    ret = seasons_table[season][year - SEASONS_TABLE_FIRST];
+    }
+  else
+    festival_compute_seasons (year, 1, season, &ret);
+  KLOG_OUT
+  return ret;
+  }
 
-  time_t tae = datetimeconv_jd_to_time (ae);
+/*============================================================================
+  
+  festival_get_autumnal_equinox
 
-  Festival *ret = festival_new (tae, TRUE, "Autumnal equinox");
+  ==========================================================================*/
+Festival *festival_get_autumnal_equinox (int year)
+  {
+  KLOG_IN
+  Festival *ret = festival_new (festival_get_season (year, 
+    FESTIVAL_SEPTEMBER_EQUINOX), TRUE, "Autumnal equinox");
   KLOG_OUT
   return ret;
   }
@@ -114,15 +325,10 @@ time_t festival_get_date (const Festival *self)
   festival_get_ash_wednesday
 
   ==========================================================================*/
-Festival *festival_get_ash_wednesday (int year, const char *tz)
+Festival *festival_get_ash_wednesday (int year, const KTimeZone *zone)
   {
   KLOG_IN
-
-  Festival *temp = festival_get_easter_sunday (year, tz);
-  time_t t = festival_get_date(temp);
-  festival_destroy (temp);
-  t -= 46 * SECS_PER_DAY;
-  Festival *ret = festival_new (t, FALSE, "Ash Wednesday");
+  Festival *ret = festival_from_easter (year, -46, "Ash Wednesday", zone);
   KLOG_OUT
   return ret;
   }
@@ -132,15 +338,10 @@ Festival *festival_get_ash_wednesday (int year, const char *tz)
   Festival 
 
   ==========================================================================*/
-Festival *festival_get_easter_monday (int year, const char *tz)
+Festival *festival_get_easter_monday (int year, const KTimeZone *zone)
   {
   KLOG_IN
-
-  Festival *temp = festival_get_easter_sunday (year, tz);
-  time_t t = festival_get_date(temp);
-  festival_destroy (temp);
-  t += SECS_PER_DAY;
-  Festival *ret = festival_new (t, FALSE, "Easter Monday");
+  Festival *ret = festival_from_easter (year, 1, "Easter Monday", zone);
   KLOG_OUT
   return ret;
   }
@@ -150,32 +351,10 @@ Festival *festival_get_easter_monday (int year, const char *tz)
   Festival 
 
   ==========================================================================*/
-Festival *festival_get_easter_sunday (int year, const char *tz)
+Festival *festival_get_easter_sunday (int year, const KTimeZone *zone)
   {
   KLOG_IN
-  int n_year = year;
-  int nA = n_year % 19;
-  int nB = n_year / 100;
-  int nC = n_year % 100;
-  int nD = nB / 4;
-  int nE = nB % 4;
-  int nF = (nB + 8) / 25;
-  int nG = (nB - nF + 1) / 3;
-  int nH = (19 * nA + nB - nD - nG + 15) % 30;
-  int nI = nC / 4;
-  int nK = nC % 4;
-  int nL = (32 + 2 * nE + 2 * nI - nH - nK) % 7;
-  int nM = (nA + 11 * nH + 22 * nL) / 451;
-  int n_easter_month = (nH + nL - 7 * nM + 114) / 31;
-  --n_easter_month;
-  int nP = (nH + nL - 7 * nM + 114) % 31;
-  int n_easter_day = nP + 1;
-  n_year -= 1900;
-
-  time_t t = datetimeconv_maketime (year, n_easter_month + 1, n_easter_day, 
-         2, 0, 0, tz);
-
-  Festival *ret = festival_new (t, FALSE, "Easter Sunday"); 
+  Festival *ret = festival_from_easter (year, 0, "Easter Sunday", zone);
   KLOG_OUT
   return ret;
   }
@@ -185,15 +364,10 @@ Festival *festival_get_easter_sunday (int year, const char *tz)
   festival_get_good_friday 
 
   ==========================================================================*/
-Festival *festival_get_good_friday (int year, const char *tz)
+Festival *festival_get_good_friday (int year, const KTimeZone *zone)
   {
   KLOG_IN
-
-  Festival *temp = festival_get_easter_sunday (year, tz);
-  time_t t = festival_get_date(temp);
-  festival_destroy (temp);
-  t -= 2 * SECS_PER_DAY;
-  Festival *ret = festival_new (t, FALSE, "Good Friday");
+  Festival *ret = festival_from_easter (year, -2, "Good Friday", zone);
   KLOG_OUT
   return ret;
   }
@@ -203,15 +377,10 @@ Festival *festival_get_good_friday (int year, const char *tz)
   festival_get_maundy_thursday
 
   ==========================================================================*/
-Festival *festival_get_maundy_thursday (int year, const char *tz)
+Festival *festival_get_maundy_thursday (int year, const KTimeZone *zone)
   {
   KLOG_IN
-
-  Festival *temp = festival_get_easter_sunday (year, tz);
-  time_t t = festival_get_date(temp);
-  festival_destroy (temp);
-  t -= 3 * SECS_PER_DAY;
-  Festival *ret = festival_new (t, FALSE, "Maundy Thursday");
+  Festival *ret = festival_from_easter (year, -3, "Maundy Thursday", zone);
   KLOG_OUT
   return ret;
   }
@@ -221,15 +390,10 @@ Festival *festival_get_maundy_thursday (int year, const char *tz)
   festival_get_mothering_sunday
 
   ==========================================================================*/
-Festival *festival_get_mothering_sunday (int year, const char *tz)
+Festival *festival_get_mothering_sunday (int year, const KTimeZone *zone)
   {
   KLOG_IN
-
-  Festival *temp = festival_get_easter_sunday (year, tz);
-  time_t t = festival_get_date(temp);
-  festival_destroy (temp);
-  t -= 21 * SECS_PER_DAY;
-  Festival *ret = festival_new (t, FALSE, "Mothering Sunday");
+  Festival *ret = festival_from_easter (year, -21, "Mothering Sunday", zone);
   KLOG_OUT
   return ret;
   }
@@ -252,15 +416,10 @@ const char *festival_get_name (const Festival *self)
   festival_get_palm_sunday
 
   ==========================================================================*/
-Festival *festival_get_palm_sunday (int year, const char *tz)
+Festival *festival_get_palm_sunday (int year, const KTimeZone *zone)
   {
   KLOG_IN
-
-  Festival *temp = festival_get_easter_sunday (year, tz);
-  time_t t = festival_get_date(temp);
-  festival_destroy (temp);
-  t -= 7 * SECS_PER_DAY;
-  Festival *ret = festival_new (t, FALSE, "Palm Sunday");
+  Festival *ret = festival_from_easter (year, -7, "Palm Sunday", zone);
   KLOG_OUT
   return ret;
   }
@@ -270,15 +429,10 @@ Festival *festival_get_palm_sunday (int year, const char *tz)
   festival_get_shrove_tuesday
 
   ==========================================================================*/
-Festival *festival_get_shrove_tuesday (int year, const char *tz)
+Festival *festival_get_shrove_tuesday (int year, const KTimeZone *zone)
   {
   KLOG_IN
-
-  Festival *temp = festival_get_easter_sunday (year, tz);
-  time_t t = festival_get_date(temp);
-  festival_destroy (temp);
-  t -= 47 * SECS_PER_DAY;
-  Festival *ret = festival_new (t, FALSE, "Shrove Tuesday");
+  Festival *ret = festival_from_easter (year, -47, "Shrove Tuesday", zone);
   KLOG_OUT
   return ret;
   }
@@ -291,24 +445,9 @@ Festival *festival_get_shrove_tuesday (int year, const char *tz)
 Festival *festival_get_summer_solstice (int year, BOOL southern)
   {
   KLOG_IN
-
-  double m = (year - 2000.0) / 1000.0;
-  double ss;
-  if (southern)
-     ss = 2451900.05952 + 365242.74049 * m - 0.06223 * m
-      * m - 0.00823 * m * m * m + 0.00032 * m * m * m * m ;
-  else
-     ss = 2451716.56767 + 365241.62603 * m + 0.00325 * m
-      * m + 0.00888 * m * m * m - 0.00030 * m * m * m * m ;
-  double t = (ss - 2451545.0) / 36525.0;
-  double w = 35999.373*t - 2.47;
-  double dL = 1 + 0.0334*mathutil_cos_deg(w) + 0.0007*mathutil_cos_deg(2*w);
-  double s = periodic24 (t);
-  ss = ss + ((0.00001*s) / dL);
-
-  time_t tss = datetimeconv_jd_to_time (ss);
-
-  Festival *ret = festival_new (tss, TRUE, "Summer solstice");
+  Festival *ret = festival_new (festival_get_season (year, 
+    southern ? FESTIVAL_DECEMBER_SOLSTICE : FESTIVAL_JUNE_SOLSTICE), 
+    TRUE, "Summer solstice");
   KLOG_OUT
   return ret;
   }
@@ -321,19 +460,8 @@ Festival *festival_get_summer_solstice (int year, BOOL southern)
 Festival *festival_get_vernal_equinox (int year)
   {
   KLOG_IN
-
-  double m = (year - 2000.0) / 1000.0;
-  double ve = 2451623.80984 + 365242.37404 * m + 0.05169 * m
-       * m - 0.00411 * m * m * m - 0.00057 * m * m * m * m ;
-  double t = (ve - 2451545.0) / 36525.0;
-  double w = 35999.373*t - 2.47;
-  double dL = 1 + 0.0334*mathutil_cos_deg(w) + 0.0007*mathutil_cos_deg(2*w);
-  double s = periodic24 (t);
-  ve = ve + ((0.00001*s) / dL);
-
-  time_t tve = datetimeconv_jd_to_time (ve);
-
-  Festival *ret = festival_new (tve, TRUE, "Vernal equinox");
+  Festival *ret = festival_new (festival_get_season (year, 
+    FESTIVAL_MARCH_EQUINOX), TRUE, "Vernal equinox");
   KLOG_OUT
   return ret;
   }
@@ -346,24 +474,9 @@ Festival *festival_get_vernal_equinox (int year)
 Festival *festival_get_winter_solstice (int year, BOOL southern)
   {
   KLOG_IN
-
-  double m = (year - 2000.0) / 1000.0;
-  double ws;
-  if (southern)
-    ws = 2451716.56767 + 365241.62603 * m + 0.00325 * m
-      * m + 0.00888 * m * m * m - 0.00030 * m * m * m * m ;
-  else
-    ws = 2451900.05952 + 365242.74049 * m - 0.06223 * m
-      * m - 0.00823 * m * m * m + 0.00032 * m * m * m * m ;
-  double t = (ws - 2451545.0) / 36525.0;
-  double w = 35999.373*t - 2.47;
-  double dL = 1 + 0.0334*mathutil_cos_deg(w) + 0.0007*mathutil_cos_deg(2*w);
-  double s = periodic24 (t);
-  ws = ws + ((0.00001*s) / dL);
-
-  time_t tws = datetimeconv_jd_to_time (ws);
-
-  Festival *ret = festival_new (tws, TRUE, "Winter solstice");
+  Festival *ret = festival_new (festival_get_season (year, 
+    southern ? FESTIVAL_JUNE_SOLSTICE : FESTIVAL_DECEMBER_SOLSTICE), 
+    TRUE, "Winter solstice");
   KLOG_OUT
   return ret;
   }
@@ -373,15 +486,10 @@ Festival *festival_get_winter_solstice (int year, BOOL southern)
   festival_get_whitsun
 
   ==========================================================================*/
-Festival *festival_get_whitsun (int year, const char *tz)
+Festival *festival_get_whitsun (int year, const KTimeZone *zone)
   {
   KLOG_IN
-
-  Festival *temp = festival_get_easter_sunday (year, tz);
-  time_t t = festival_get_date(temp);
-  festival_destroy (temp);
-  t += 49 * SECS_PER_DAY;
-  Festival *ret = festival_new (t, FALSE, "Whitsun/Pentecost");
+  Festival *ret = festival_from_easter (year, 49, "Whitsun/Pentecost", zone);
   KLOG_OUT
   return ret;
   }
@@ -404,7 +512,8 @@ BOOL festival_has_time (const Festival *self)
   festival_to_string 
 
   ==========================================================================*/
-KString *festival_to_string (const Festival *self, const char *tz)
+KString *festival_to_string (const Festival *self, 
+          const KTimeZone *zone)
   {
   KLOG_IN
   static char *months[12] = 
@@ -412,19 +521,13 @@ KString *festival_to_string (const Festival *self, const char *tz)
       "Sep", "Oct", "Nov", "Dec"};
   static char *days[7] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
 
-  char *oldtz = NULL;
-  if (tz)
-    {
-    oldtz = getenv_dup ("TZ");
-    my_setenv ("TZ", tz, 1);
-    tzset ();
-    }
-
-  KString *s = kstring_new_empty ();
-  
   struct tm tm;
-  localtime_r (&self->date, &tm);  
+  if (zone)
+    ktimezone_utc_to_local (zone, self->date, &tm);
+  else
+    localtime_r (&self->date, &tm);  
 
+  KString *s = kstring_new_empty ();
   kstring_append_printf (s, "%s %s %d %s", 
         days[tm.tm_wday], months[tm.tm_mon], tm.tm_mday, self->name);
   if (self->has_time)
@@ -432,80 +535,7 @@ KString *festival_to_string (const Festival *self, const char *tz)
     kstring_append_printf (s, " (%02d:%02d)", tm.tm_hour, tm.tm_min);
     }
 
-  if (tz)
-    {
-    my_setenv ("TZ", oldtz, 1);
-    if (oldtz) free (oldtz);
-    tzset ();
-    }
-
   KLOG_OUT
   return s;
   }
 
-/*=======================================================================
-
-  getenv_dup
-
-  Gets a copy of an environment string. Caller must free it, if it is
-  not NULL
-
-=======================================================================*/
-static char *getenv_dup (const char *env)
-  {
-  KLOG_IN
-  char *s = getenv (env);
-  KLOG_OUT
-  if (s) return strdup (s);
-  return NULL;
-  }
-
-/*=======================================================================
-
-  my_setenv
-
-  A variant of setenv() that allows a NULL value to call unsetenv; 
-  setenv() itself does not accept NULL as a value
-
-=======================================================================*/
-static void my_setenv (const char *name, const char *value, BOOL dummy)
-  {
-  KLOG_IN
-  if (value)
-    setenv (name, value, 1);
-  else
-    unsetenv (name);
-  KLOG_OUT
-  }
-
-/*============================================================================
-  
-  periodic24
-
-  Meeus' correction method for solstices. Don't ask me how the math
-  works :)
-
-=======================================================================*/
-double periodic24 (double t)
-  {
-  int i;
-  static double A[24] = {485,203,199,182,156,136,77,74,70,58,
-      52,50,45,44,29,18,17,16,14,12,12,12,9,8};
-  static double B[24] = {324.96,337.23,342.08,27.85,73.14,
-      171.52,222.54,296.72,243.58,119.81,297.17,21.02, 247.54,
-      325.15,60.93,155.12,288.79,198.04,199.76,95.39,287.11,
-      320.81,227.73,15.45};
-  static double C[24] = {1934.136,32964.467,20.186,445267.112,
-      45036.886,22518.443, 65928.934,3034.906,9037.513,33718.147,
-      150.678,2281.226, 29929.562,31555.956,4443.417,67555.328,
-      4562.452,62894.029, 31436.921,14577.848,31931.756,34777.259,
-      1222.114,16859.074};
-  double s = 0.0;
-  for (i = 0; i < 24; i++)
-    s += A[i]*mathutil_cos_deg(B[i] + C[i]*t);
-  return s;
-  }
-
-
-
-
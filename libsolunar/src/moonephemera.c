@@ -15,6 +15,8 @@
 #include <memory.h>
 #include <assert.h>
 #include <math.h>
+#include <string.h>
+#include <pthread.h>
 #include <libsolunar/moonephemera.h>
 #include <libsolunar/astroutil.h>
 #include <klib/klog.h>
@@ -197,13 +199,25 @@ void moonephemera_get_moon_state (double latitude, double longitude,
 
 /*============================================================================
   
-  moonephemera_get_ra_and_dec
+  moonephemera_series_ra_and_dec
+
+  The original, series, implementation of get_ra_and_dec. This takes
+  a modified Julian date, rather than a time_t, so it can be evaluated 
+  at fractions of a second.
+
+  The half-angle formula for RA misbehaves close to 12 hours, because 
+  the rounded obliquity constants do not make an exact rotation, and 
+  X + RHO can come out near zero, or even negative; RA can then be 
+  off by a few hundredths of an hour for some minutes. The smooth 
+  flag selects atan2() instead, which does not have this problem. It
+  is used when fitting polynomials, which would otherwise spread the
+  error over the whole day; the default output is unchanged.
 
   ==========================================================================*/
-void moonephemera_get_ra_and_dec (time_t tu, double *ra, double *dec)
+static void moonephemera_series_ra_and_dec (double mjd, BOOL smooth, 
+         double *ra, double *dec)
   {
   KLOG_IN
-  double mjd = datetimeconv_time_to_mjd (tu);
   const double CosEPS = 0.91748;
   const double SinEPS = 0.39778;
   const double ARC = 206264.8062;
@@ -241,7 +255,11 @@ void moonephemera_get_ra_and_dec (time_t tu, double *ra, double *dec)
   double Z = SinEPS * V + CosEPS * W;
   double RHO = sqrt(1.0 - Z*Z);
   double _dec = (360.0 / P2) * atan(Z / RHO);
-  double _ra = (48.0 / P2) * atan(Y / (X + RHO));
+  double _ra;
+  if (smooth)
+    _ra = (24.0 / P2) * atan2 (Y, X);
+  else
+    _ra = (48.0 / P2) * atan(Y / (X + RHO));
 
   if (_ra < 0) _ra += 24 ;
 
@@ -251,5 +269,200 @@ void moonephemera_get_ra_and_dec (time_t tu, double *ra, double *dec)
   KLOG_OUT
   }
 
+/*============================================================================
+  
+  Chebyshev backend
+
+  The series is approximated, one UTC day at a time, by Chebyshev 
+  polynomials in time, fitted at the Chebyshev nodes of the day. The 
+  lunar terms have periods of days at the shortest, so a polynomial of
+  modest degree reproduces the series to far better than its own 
+  accuracy. RA wraps from 24 to 0 hours once a month, so it is 
+  unwrapped before fitting, and wrapped again after evaluation. 
+  Segments are fitted when first needed, and kept in a direct-mapped
+  table of slots, with a lock for each slot.
+
+  ==========================================================================*/
+#define CHEB_SPAN 86400
+#define CHEB_ORDER 9 // Number of coefficients
+#define CHEB_SLOTS 64
+
+typedef struct _ChebSegment
+  {
+  pthread_mutex_t lock;
+  BOOL valid;
+  long day; // Days since the epoch
+  double ra[CHEB_ORDER];
+  double dec[CHEB_ORDER];
+  } ChebSegment;
+
+static ChebSegment cheb_segments[CHEB_SLOTS];
+static pthread_once_t cheb_once = PTHREAD_ONCE_INIT;
+
+static MoonEphemeraBackend backend = MOONEPHEMERA_SERIES;
+
+/*============================================================================
+  
+  moonephemera_cheb_init
+
+  ==========================================================================*/
+static void moonephemera_cheb_init (void)
+  {
+  for (int i = 0; i < CHEB_SLOTS; i++)
+    {
+    pthread_mutex_init (&cheb_segments[i].lock, NULL);
+    cheb_segments[i].valid = FALSE;
+    }
+  }
+
+/*============================================================================
+  
+  moonephemera_cheb_fit
+
+  Fit the segment for the day that starts at t0.
+
+  ==========================================================================*/
+static void moonephemera_cheb_fit (time_t t0, double *c_ra, double *c_dec)
+  {
+  KLOG_IN
+  const int n = CHEB_ORDER;
+  double mjd0 = datetimeconv_time_to_mjd (t0);
+  double f_ra[CHEB_ORDER];
+  double f_dec[CHEB_ORDER];
+
+  for (int k = 0; k < n; k++)
+    {
+    double x = cos (M_PI * (k + 0.5) / n);
+    double mjd = mjd0 + (x + 1.0) / 2.0 * CHEB_SPAN / 86400.0;
+    moonephemera_series_ra_and_dec (mjd, TRUE, &f_ra[k], &f_dec[k]);
+    if (k > 0)
+      {
+      while (f_ra[k] - f_ra[k - 1] > 12) f_ra[k] -= 24;
+      while (f_ra[k] - f_ra[k - 1] < -12) f_ra[k] += 24;
+      }
+    }
+
+  for (int j = 0; j < n; j++)
+    {
+    double sum_ra = 0;
+    double sum_dec = 0;
+    for (int k = 0; k < n; k++)
+      {
+      double c = cos (M_PI * j * (k + 0.5) / n);
+      sum_ra += f_ra[k] * c;
+      sum_dec += f_dec[k] * c;
+      }
+    c_ra[j] = 2.0 * sum_ra / n;
+    c_dec[j] = 2.0 * sum_dec / n;
+    }
+  KLOG_OUT
+  }
+
+/*============================================================================
+  
+  moonephemera_cheb_eval
+
+  Clenshaw's recurrence, for x in -1..1
+
+  ==========================================================================*/
+static double moonephemera_cheb_eval (const double *c, double x)
+  {
+  double b1 = 0, b2 = 0;
+  double x2 = 2.0 * x;
+  for (int j = CHEB_ORDER - 1; j >= 1; j--)
+    {
+    double b0 = x2 * b1 - b2 + c[j];
+    b2 = b1;
+    b1 = b0;
+    }
+  return x * b1 - b2 + 0.5 * c[0];
+  }
 
+/*============================================================================
+  
+  moonephemera_cheb_ra_and_dec
+
+  ==========================================================================*/
+static void moonephemera_cheb_ra_and_dec (time_t t, double *ra, double *dec)
+  {
+  KLOG_IN
+  pthread_once (&cheb_once, moonephemera_cheb_init);
+
+  long day = t / CHEB_SPAN;
+  if (t < 0 && t % CHEB_SPAN != 0) day--;
+  time_t t0 = (time_t)day * CHEB_SPAN;
+  ChebSegment *seg = &cheb_segments[(unsigned long)day % CHEB_SLOTS];
+
+  double c_ra[CHEB_ORDER];
+  double c_dec[CHEB_ORDER];
+
+  pthread_mutex_lock (&seg->lock);
+  BOOL hit = seg->valid && seg->day == day;
+  if (hit)
+    {
+    memcpy (c_ra, seg->ra, sizeof (c_ra));
+    memcpy (c_dec, seg->dec, sizeof (c_dec));
+    }
+  pthread_mutex_unlock (&seg->lock);
+
+  if (!hit)
+    {
+    klog_debug (KLOG_CLASS, "Fitting moon position for day %ld", day);
+    moonephemera_cheb_fit (t0, c_ra, c_dec);
+    pthread_mutex_lock (&seg->lock);
+    memcpy (seg->ra, c_ra, sizeof (c_ra));
+    memcpy (seg->dec, c_dec, sizeof (c_dec));
+    seg->day = day;
+    seg->valid = TRUE;
+    pthread_mutex_unlock (&seg->lock);
+    }
+
+  double x = 2.0 * (double)(t - t0) / CHEB_SPAN - 1.0;
+  double _ra = fmod (moonephemera_cheb_eval (c_ra, x), 24.0);
+  if (_ra < 0) _ra += 24;
+  *ra = _ra;
+  *dec = moonephemera_cheb_eval (c_dec, x);
+  KLOG_OUT
+  }
+
+/*============================================================================
+  
+  moonephemera_get_ra_and_dec
+
+  ==========================================================================*/
+void moonephemera_get_ra_and_dec (time_t tu, double *ra, double *dec)
+  {
+  KLOG_IN
+  if (backend == MOONEPHEMERA_CHEBYSHEV)
+    moonephemera_cheb_ra_and_dec (tu, ra, dec);
+  else
+    moonephemera_series_ra_and_dec (datetimeconv_time_to_mjd (tu), FALSE, 
+      ra, dec);
+  KLOG_OUT
+  }
+
+/*============================================================================
+  
+  moonephemera_set_backend
+
+  ==========================================================================*/
+void moonephemera_set_backend (MoonEphemeraBackend b)
+  {
+  KLOG_IN
+  backend = b;
+  KLOG_OUT
+  }
+
+/*============================================================================
+  
+  moonephemera_get_backend
+
+  ==========================================================================*/
+MoonEphemeraBackend moonephemera_get_backend (void)
+  {
+  KLOG_IN
+  MoonEphemeraBackend ret = backend;
+  KLOG_OUT
+  return ret;
+  }
 
@@ -0,0 +1,135 @@
+/*============================================================================
+  
+  libsolunar 
+  
+  moonposcache.c
+
+  The cache is a direct-mapped table of slots, each holding the 
+  positions for one UTC day, and selected by the day number. A slot is
+  filled outside its lock, so that a thread computing one day does not
+  hold up threads reading another day that maps to the same slot; if
+  two threads fill the same day at once, they store the same values.
+  Requests for the same few days -- usually today and tomorrow -- come
+  from every city, so a small table is sufficient.
+
+  Copyright (c)1990-2020 Kevin Boone. Distributed under the terms of the
+  GNU Public Licence, v3.0
+
+  ==========================================================================*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <libsolunar/moonephemera.h>
+#include <libsolunar/moonposcache.h>
+#include <libsolunar/astroutil.h>
+#include <klib/klog.h>
+
+#define KLOG_CLASS "libsolunar.moonposcache"
+
+#define SECS_PER_DAY 86400
+#define STEPS_PER_DAY (SECS_PER_DAY / MOONPOSCACHE_STEP)
+#define NUM_SLOTS 64
+
+typedef struct _MoonPosSlot
+  {
+  pthread_mutex_t lock;
+  BOOL valid;
+  long day; // Days since the epoch
+  double ra[STEPS_PER_DAY];
+  double dec[STEPS_PER_DAY];
+  } MoonPosSlot;
+
+static MoonPosSlot slots[NUM_SLOTS];
+static pthread_once_t slots_once = PTHREAD_ONCE_INIT;
+
+/*============================================================================
+  
+  moonposcache_init
+
+  ==========================================================================*/
+static void moonposcache_init (void)
+  {
+  for (int i = 0; i < NUM_SLOTS; i++)
+    {
+    pthread_mutex_init (&slots[i].lock, NULL);
+    slots[i].valid = FALSE;
+    }
+  }
+
+/*============================================================================
+  
+  moonposcache_get_ra_and_dec
+
+  ==========================================================================*/
+void moonposcache_get_ra_and_dec (time_t t, double *ra, double *dec)
+  {
+  KLOG_IN
+  if (t % MOONPOSCACHE_STEP != 0)
+    {
+    moonephemera_get_ra_and_dec (t, ra, dec);
+    KLOG_OUT
+    return;
+    }
+
+  pthread_once (&slots_once, moonposcache_init);
+
+  long day = t / SECS_PER_DAY;
+  if (t < 0 && t % SECS_PER_DAY != 0) day--;
+  int step = (t - (time_t)day * SECS_PER_DAY) / MOONPOSCACHE_STEP;
+  MoonPosSlot *slot = &slots[(unsigned long)day % NUM_SLOTS];
+
+  pthread_mutex_lock (&slot->lock);
+  BOOL hit = slot->valid && slot->day == day;
+  if (hit)
+    {
+    *ra = slot->ra[step];
+    *dec = slot->dec[step];
+    }
+  pthread_mutex_unlock (&slot->lock);
+
+  if (!hit)
+    {
+    klog_debug (KLOG_CLASS, "Computing moon positions for day %ld", day);
+    double day_ra[STEPS_PER_DAY];
+    double day_dec[STEPS_PER_DAY];
+    time_t t0 = (time_t)day * SECS_PER_DAY;
+    for (int i = 0; i < STEPS_PER_DAY; i++)
+      moonephemera_get_ra_and_dec (t0 + i * MOONPOSCACHE_STEP, 
+        &day_ra[i], &day_dec[i]);
+
+    pthread_mutex_lock (&slot->lock);
+    for (int i = 0; i < STEPS_PER_DAY; i++)
+      {
+      slot->ra[i] = day_ra[i];
+      slot->dec[i] = day_dec[i];
+      }
+    slot->day = day;
+    slot->valid = TRUE;
+    pthread_mutex_unlock (&slot->lock);
+
+    *ra = day_ra[step];
+    *dec = day_dec[step];
+    }
+  KLOG_OUT
+  }
+
+/*============================================================================
+  
+  moonposcache_get_sin_altitude
+
+  ==========================================================================*/
+double moonposcache_get_sin_altitude (double latitude, double longitude, 
+          time_t t)
+  {
+  KLOG_IN
+  double ra, dec;
+  moonposcache_get_ra_and_dec (t, &ra, &dec);
+
+  double result = astroutil_ra_dec_to_sin_altitude (t, latitude, longitude, 
+           ra, dec);
+
+  KLOG_OUT
+  return result;
+  }
+
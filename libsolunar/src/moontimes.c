@@ -15,6 +15,7 @@
 #include <assert.h>
 #include <math.h>
 #include <libsolunar/moonephemera.h>
+#include <libsolunar/moonposcache.h>
 #include <libsolunar/moontimes.h>
 #include <libsolunar/astroutil.h>
 #include <klib/klog.h>
@@ -24,92 +25,316 @@
 
 #define KLOG_CLASS "libsolunar.moontimes"
 
-#define INTERVAL (15*60)
+// The sampling interval is the grid spacing of the position cache, so
+//  that, for a day starting on the grid, every sample is a cache hit
+#define INTERVAL MOONPOSCACHE_STEP
+
+static MoonTimesSolver solver = MOONTIMES_SAMPLED;
 
 /*============================================================================
   
-  moontimes_get_moonrises
+  moontimes_sampled_events
+
+  The altitude is sampled at INTERVAL steps, and each new sample 
+  completes a window of three, which is checked for both an upward
+  and a downward crossing of the horizon. Only the current window is
+  kept, so nothing need be allocated.
 
   ==========================================================================*/
-void moontimes_get_moonrises (time_t start, time_t end, double latitude, 
-      double longitude, time_t *rises, int max, int *count) 
+static void moontimes_sampled_events (time_t start, time_t end, 
+      double latitude, double longitude, time_t *rises, int max_rises, 
+      int *nrises, time_t *sets, int max_sets, int *nsets) 
   {
   KLOG_IN
   assert (end > start);
   int diff = end - start;
   int npoints = diff / INTERVAL + 1;
-  *count = 0;
-
-  double *x = (double *) malloc (npoints * sizeof (double));
-  double *y = (double *) malloc (npoints * sizeof (double));
-  double *d_events = malloc (max * sizeof (double));
+  *nrises = 0;
+  *nsets = 0;
 
-  time_t tx = start;
-  for (int i = 0; i < npoints; i++)
+  if (npoints >= 3)
     {
-    double alt = moonephemera_get_sin_altitude
-      (latitude, longitude, tx);
-    x[i] = i * INTERVAL;
-    y[i] = alt;
-    tx += INTERVAL;
+    double y0 = moonposcache_get_sin_altitude (latitude, longitude, start);
+    double y1 = moonposcache_get_sin_altitude (latitude, longitude, 
+      start + INTERVAL);
+
+    for (int i = 1; i < npoints - 1 
+         && (*nrises < max_rises || *nsets < max_sets); i++)
+      {
+      double y2 = moonposcache_get_sin_altitude (latitude, longitude, 
+        start + (i + 1) * INTERVAL);
+      double bisect;
+      // Crossing times are in seconds after 'start'
+      if (*nrises < max_rises && y0 < 0 && y1 <= 0 && y2 > 0)
+        {
+        if (mathutil_interpolate_crossing (y0, y1, y2, &bisect))
+          {
+          double d = (double)(i * INTERVAL) + bisect * INTERVAL;
+          rises[*nrises] = start + d;
+          (*nrises)++;
+          }
+        }
+      else if (*nsets < max_sets && y0 > 0 && y1 >= 0 && y2 < 0)
+        {
+        if (mathutil_interpolate_crossing (y0, y1, y2, &bisect))
+          {
+          double d = (double)(i * INTERVAL) + bisect * INTERVAL;
+          sets[*nsets] = start + d;
+          (*nsets)++;
+          }
+        }
+      y0 = y1;
+      y1 = y2;
+      }
     }
 
-  mathutil_get_positive_axis_crossings (x, y, npoints, d_events,
-    max, count);
-  // Axis crossing times are in seconds after the first x value, that
-  //  is, seconds after the 'start' value
+  KLOG_OUT
+  }
+
+/*============================================================================
+  
+  Adaptive solver
+
+  The altitude is sampled every COARSE_INTERVAL, and each interval 
+  whose ends straddle the horizon is narrowed down to a second by 
+  regula falsi, with the Illinois modification so that one end does
+  not get stuck. 
+
+  An interval whose ends are on the same side of the horizon might 
+  still contain a rise and a set, if the moon just grazes the horizon
+  -- this happens at high latitudes -- and one whose ends straddle 
+  the horizon might contain a rise, a set, and another rise. Since 
+  sin(alt) = sin(lat) sin(dec) + cos(lat) cos(dec) cos(H), the sine of
+  the altitude can change no faster than 
+  |cos(lat)| (H_RATE + DEC_RATE) + |sin(lat)| DEC_RATE, where H_RATE
+  and DEC_RATE bound the rates of change of the hour angle and the
+  declination. If the ends of an interval are so far from the horizon
+  that the moon would need all the time available just to get from 
+  one to the other by way of the horizon, it can't have turned at the
+  horizon, and the interval contains no crossing other than the one
+  (if any) that its ends imply. Otherwise the interval is split, down
+  to MIN_INTERVAL, before any crossing is refined.
+
+  ==========================================================================*/
+#define COARSE_INTERVAL (2*60*60)
+#define MIN_INTERVAL 60
+// The moon's hour angle increases by 2*pi in about 24h50m; since the 
+//  moon's RA only ever increases, it can't do so faster than the 
+//  sidereal rate, 2*pi in a sidereal day. Radians per second
+#define H_RATE (2.0 * M_PI / 86164.1)
+// The moon's declination changes by at most about 7.3 degrees a day.
+//  Radians per second
+#define DEC_RATE (8.0 * M_PI / 180.0 / 86400.0)
+
+typedef struct _MoonEventSearch
+  {
+  double latitude;
+  double longitude;
+  double max_rate; // Largest possible change in sin(alt) per second
+  time_t *rises;
+  int max_rises;
+  int *nrises;
+  time_t *sets;
+  int max_sets;
+  int *nsets;
+  } MoonEventSearch;
+
+/*============================================================================
+  
+  moontimes_refine
+
+  Find the time, to the second, at which the altitude crosses zero
+  between a and b, where fa and fb have opposite signs, or fb is zero.
+
+  ==========================================================================*/
+static time_t moontimes_refine (const MoonEventSearch *search, 
+      time_t a, double fa, time_t b, double fb)
+  {
+  KLOG_IN
+  int side = 0;
+  while (b - a > 1 && fb != 0.0)
+    {
+    time_t c = a + (time_t) floor ((b - a) * fa / (fa - fb) + 0.5);
+    if (c <= a) c = a + 1;
+    if (c >= b) c = b - 1;
+    double fc = moonposcache_get_sin_altitude (search->latitude, 
+      search->longitude, c);
+    if ((fc < 0) == (fb < 0))
+      {
+      b = c; fb = fc;
+      if (side == -1) fa /= 2;
+      side = -1;
+      }
+    else
+      {
+      a = c; fa = fc;
+      if (side == 1) fb /= 2;
+      side = 1;
+      }
+    }
+  time_t ret = b;
+  if (b - a <= 1 && fabs (fa) < fabs (fb)) ret = a;
+  KLOG_OUT
+  return ret;
+  }
 
-  for (int i = 0; i < *count; i++)
-    rises[i] = start + d_events[i];
+/*============================================================================
+  
+  moontimes_search_interval
 
-  free (d_events);
-  free (x);
-  free (y);
+  Returns FALSE when there is no room for any more events.
 
+  ==========================================================================*/
+static BOOL moontimes_search_interval (const MoonEventSearch *search, 
+      time_t a, double fa, time_t b, double fb)
+  {
+  KLOG_IN
+  BOOL ret = TRUE;
+  if (b - a > MIN_INTERVAL 
+       && fabs (fa) + fabs (fb) <= search->max_rate * (b - a))
+    {
+    time_t m = a + (b - a) / 2;
+    double fm = moonposcache_get_sin_altitude (search->latitude, 
+      search->longitude, m);
+    if (moontimes_search_interval (search, a, fa, m, fm))
+      moontimes_search_interval (search, m, fm, b, fb);
+    }
+  else if (fa < 0 && fb >= 0)
+    {
+    if (*search->nrises < search->max_rises)
+      {
+      search->rises[*search->nrises] = moontimes_refine 
+        (search, a, fa, b, fb);
+      (*search->nrises)++;
+      }
+    }
+  else if (fa > 0 && fb <= 0)
+    {
+    if (*search->nsets < search->max_sets)
+      {
+      search->sets[*search->nsets] = moontimes_refine 
+        (search, a, fa, b, fb);
+      (*search->nsets)++;
+      }
+    }
+  ret = *search->nrises < search->max_rises 
+     || *search->nsets < search->max_sets;
   KLOG_OUT
+  return ret;
   }
 
 /*============================================================================
   
-  moontimes_get_moonsets
+  moontimes_adaptive_events
 
   ==========================================================================*/
-void moontimes_get_moonsets (time_t start, time_t end, double latitude, 
-      double longitude, time_t *rises, int max, int *count) 
+static void moontimes_adaptive_events (time_t start, time_t end, 
+      double latitude, double longitude, time_t *rises, int max_rises, 
+      int *nrises, time_t *sets, int max_sets, int *nsets) 
   {
   KLOG_IN
   assert (end > start);
-  int diff = end - start;
-  int npoints = diff / INTERVAL + 1;
-  *count = 0;
+  *nrises = 0;
+  *nsets = 0;
 
-  double *x = (double *) malloc (npoints * sizeof (double));
-  double *y = (double *) malloc (npoints * sizeof (double));
-  double *d_events = malloc (max * sizeof (double));
+  MoonEventSearch search;
+  search.latitude = latitude;
+  search.longitude = longitude;
+  search.max_rate = fabs (mathutil_cos_deg (latitude)) * (H_RATE + DEC_RATE)
+    + fabs (mathutil_sin_deg (latitude)) * DEC_RATE;
+  search.rises = rises;
+  search.max_rises = max_rises;
+  search.nrises = nrises;
+  search.sets = sets;
+  search.max_sets = max_sets;
+  search.nsets = nsets;
 
-  time_t tx = start;
-  for (int i = 0; i < npoints; i++)
+  time_t a = start;
+  double fa = moonposcache_get_sin_altitude (latitude, longitude, a);
+  BOOL more = (max_rises > 0 || max_sets > 0);
+  while (more && a < end)
     {
-    double alt = moonephemera_get_sin_altitude
-      (latitude, longitude, tx);
-    x[i] = i * INTERVAL;
-    y[i] = alt;
-    tx += INTERVAL;
+    time_t b = a + COARSE_INTERVAL;
+    if (b > end) b = end;
+    double fb = moonposcache_get_sin_altitude (latitude, longitude, b);
+    more = moontimes_search_interval (&search, a, fa, b, fb);
+    a = b;
+    fa = fb;
     }
+  KLOG_OUT
+  }
 
-  mathutil_get_negative_axis_crossings (x, y, npoints, d_events,
-    max, count);
-  // Axis crossing times are in seconds after the first x value, that
-  //  is, seconds after the 'start' value
+/*============================================================================
+  
+  moontimes_get_moon_events
 
-  for (int i = 0; i < *count; i++)
-    rises[i] = start + d_events[i];
+  ==========================================================================*/
+void moontimes_get_moon_events (time_t start, time_t end, double latitude, 
+      double longitude, time_t *rises, int max_rises, int *nrises, 
+      time_t *sets, int max_sets, int *nsets) 
+  {
+  KLOG_IN
+  if (solver == MOONTIMES_ADAPTIVE)
+    moontimes_adaptive_events (start, end, latitude, longitude, 
+      rises, max_rises, nrises, sets, max_sets, nsets);
+  else
+    moontimes_sampled_events (start, end, latitude, longitude, 
+      rises, max_rises, nrises, sets, max_sets, nsets);
+  KLOG_OUT
+  }
 
-  free (d_events);
-  free (x);
-  free (y);
+/*============================================================================
+  
+  moontimes_set_solver
 
+  ==========================================================================*/
+void moontimes_set_solver (MoonTimesSolver s)
+  {
+  KLOG_IN
+  solver = s;
+  KLOG_OUT
+  }
+
+/*============================================================================
+  
+  moontimes_get_solver
+
+  ==========================================================================*/
+MoonTimesSolver moontimes_get_solver (void)
+  {
+  KLOG_IN
+  MoonTimesSolver ret = solver;
   KLOG_OUT
+  return ret;
   }
 
+/*============================================================================
+  
+  moontimes_get_moonrises
+
+  ==========================================================================*/
+void moontimes_get_moonrises (time_t start, time_t end, double latitude, 
+      double longitude, time_t *rises, int max, int *count) 
+  {
+  KLOG_IN
+  int nsets;
+  moontimes_get_moon_events (start, end, latitude, longitude, 
+    rises, max, count, NULL, 0, &nsets);
+  KLOG_OUT
+  }
+
+/*============================================================================
+  
+  moontimes_get_moonsets
+
+  ==========================================================================*/
+void moontimes_get_moonsets (time_t start, time_t end, double latitude, 
+      double longitude, time_t *sets, int max, int *count) 
+  {
+  KLOG_IN
+  int nrises;
+  moontimes_get_moon_events (start, end, latitude, longitude, 
+    NULL, 0, &nrises, sets, max, count);
+  KLOG_OUT
+  }
 
@@ -14,6 +14,9 @@
 #include <assert.h>
 #include <errno.h>
 #include <string.h>
+#include <math.h>
+#include <stdint.h>
+#include <pthread.h>
 #include <klib/klib.h>
 #include <libsolunar/solcity.h>
 
@@ -31,61 +34,361 @@ struct _SolCity
   double latitude;
   double longitude;
   const char *tz_name;
+  // The zone object for tz_name, resolved the first time it is needed.
+  // cityinfo.h does not initialize this, so it starts out NULL
+  const KTimeZone *zone;
   };
 
+/*============================================================================
+  
+  CityHashEntry
+
+  An entry in the perfect hash of exact names, generated with the city
+  table by parse_zoneinfo.pl. 
+
+  ==========================================================================*/
+typedef struct _CityHashEntry
+  {
+  const char *key; // Folded full name or last component
+  int count;       // Number of cities that match the key
+  int first;       // Index of the first of them
+  } CityHashEntry;
+
 #include "cityinfo.h"
 
 /*============================================================================
   
-  strcmp_case 
+  City index
+
+  Matching is case-insensitive substring matching, where 'case' is 
+  folded by setting bit 5 of every byte, as it always has been. Most
+  queries are either a full zone name, or its last component 
+  ("london"). These are looked up in a minimal perfect hash, generated 
+  at build time by parse_zoneinfo.pl along with the answer for each, 
+  so they cost one hash and one string comparison, and need no setup.
+
+  Other queries use an index that holds the folded name of every city,
+  and a table of the three-byte sequences (trigrams) that occur in the
+  folded names, each with the sorted list of cities whose names 
+  contain it. Any city that matches a query must contain every 
+  trigram of the query, so only the cities listed against the 
+  query's rarest trigram need be checked. Queries shorter than three
+  bytes are checked against every name, but these match most of the 
+  cities anyway. The index is built on first use, and nothing is 
+  allocated during a lookup.
 
   ==========================================================================*/
-static void lower (char *s)
+#define MAX_QUERY 64
+
+typedef struct _Trigram
   {
+  uint32_t trigram;
+  int start; // Offset in postings
+  int count;
+  } Trigram;
+
+static int ncities;
+static char **folded;
+static Trigram *trigrams;
+static int ntrigrams;
+static int *postings;
+static pthread_once_t index_once = PTHREAD_ONCE_INIT;
+
+/*============================================================================
+  
+  solcity_fold
+
+  Fold s into buff, which has space for size bytes including the 
+  terminator. Returns the length, or -1 if s is too long.
+
+  ==========================================================================*/
+static int solcity_fold (const char *s, char *buff, int size)
+  {
+  int i = 0;
+  while (s[i])
+    {
+    if (i == size - 1) return -1;
+    buff[i] = s[i] | 32;
+    i++;
+    }
+  buff[i] = 0;
+  return i;
+  }
+
+/*============================================================================
+  
+  solcity_hash
+
+  FNV-1a, with the seed mixed into the starting value, and a final
+  avalanche step. This must match hash() in parse_zoneinfo.pl.
+
+  ==========================================================================*/
+static uint32_t solcity_hash (const char *s, uint32_t seed)
+  {
+  uint32_t h = 2166136261u ^ (seed * 0x9e3779b1u);
   while (*s)
     {
-    *s |= 32;
-    s++;
+    h ^= (unsigned char)*s++;
+    h *= 16777619u;
     }
+  h ^= h >> 16;
+  h *= 0x85ebca6bu;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35u;
+  h ^= h >> 16;
+  return h;
   }
 
 /*============================================================================
   
-  solcity_find_matching 
+  solcity_find_exact
+
+  Look up a folded key in the perfect hash. Any key maps to some 
+  entry, so the key stored there must be checked.
 
   ==========================================================================*/
-KList *solcity_find_matching (const UTF8 *s)
+static const CityHashEntry *solcity_find_exact (const char *key)
+  {
+  uint32_t d = city_hash_disp[solcity_hash (key, 0) % CITY_HASH_BUCKETS];
+  const CityHashEntry *e = &city_hash[solcity_hash (key, d) % CITY_HASH_KEYS];
+  if (strcmp (e->key, key) == 0) return e;
+  return NULL;
+  }
+
+/*============================================================================
+  
+  solcity_trigram
+
+  ==========================================================================*/
+static uint32_t solcity_trigram (const char *s)
+  {
+  return ((uint32_t)(unsigned char)s[0] << 16) 
+    | ((uint32_t)(unsigned char)s[1] << 8) | (unsigned char)s[2];
+  }
+
+/*============================================================================
+  
+  solcity_compare_pairs
+
+  Sort (trigram, city) pairs by trigram, then city
+
+  ==========================================================================*/
+static int solcity_compare_pairs (const void *a, const void *b)
+  {
+  const uint32_t *pa = a;
+  const uint32_t *pb = b;
+  if (pa[0] != pb[0]) return pa[0] < pb[0] ? -1 : 1;
+  if (pa[1] != pb[1]) return pa[1] < pb[1] ? -1 : 1;
+  return 0;
+  }
+
+/*============================================================================
+  
+  solcity_find_trigram
+
+  ==========================================================================*/
+static const Trigram *solcity_find_trigram (uint32_t t)
+  {
+  int lo = 0, hi = ntrigrams - 1;
+  while (lo <= hi)
+    {
+    int mid = (lo + hi) / 2;
+    if (trigrams[mid].trigram == t) return &trigrams[mid];
+    if (trigrams[mid].trigram < t) lo = mid + 1; else hi = mid - 1;
+    }
+  return NULL;
+  }
+
+/*============================================================================
+  
+  solcity_search
+
+  Find cities whose folded names contain the folded query q, of length
+  len, using the trigram table. If fn is not NULL, it is called for 
+  each match, in the order of the cities[] table. Returns the number of
+  matches, and the index of the first in *first.
+
+  ==========================================================================*/
+typedef void (*SolCityMatchFn) (const SolCity *city, void *user_data);
+
+static int solcity_search (const char *q, int len, int *first, 
+      SolCityMatchFn fn, void *user_data)
+  {
+  int count = 0;
+  *first = -1;
+  if (len >= 3)
+    {
+    // Find the query trigram with the fewest cities
+    const Trigram *best = NULL;
+    for (int i = 0; i + 3 <= len; i++)
+      {
+      const Trigram *t = solcity_find_trigram (solcity_trigram (q + i));
+      if (!t) return 0; // No city contains this trigram
+      if (!best || t->count < best->count) best = t;
+      }
+    for (int i = 0; i < best->count; i++)
+      {
+      int c = postings[best->start + i];
+      if (len == 3 || strstr (folded[c], q))
+        {
+        if (count == 0) *first = c;
+        count++;
+        if (fn) fn (&cities[c], user_data);
+        }
+      }
+    }
+  else
+    {
+    for (int c = 0; c < ncities; c++)
+      {
+      if (strstr (folded[c], q))
+        {
+        if (count == 0) *first = c;
+        count++;
+        if (fn) fn (&cities[c], user_data);
+        }
+      }
+    }
+  return count;
+  }
+
+/*============================================================================
+  
+  solcity_build_index
+
+  ==========================================================================*/
+static void solcity_build_index (void)
   {
   KLOG_IN
-  assert (s != NULL);
-  KList *list = NULL;
-  klog_debug (KLOG_CLASS, "Find city matching '%s'", s);
+  ncities = 0;
+  while (cities[ncities].name) ncities++;
 
-  char *slwr = strdup ((char *)s);
-  lower (slwr);
-  int i = 0;
-  SolCity *c = &cities[i];
-  while (c->name)
+  folded = malloc (ncities * sizeof (char *));
+  int npairs = 0;
+  for (int c = 0; c < ncities; c++)
     {
-    char *name = strdup (c->name);
-    lower (name);
-    if (strstr (name, (char *)slwr)) 
+    folded[c] = strdup (cities[c].name);
+    int len = strlen (folded[c]);
+    solcity_fold (cities[c].name, folded[c], len + 1);
+    if (len >= 3) npairs += len - 2;
+    }
+
+  // Trigram table
+  uint32_t *pairs = malloc (npairs * 2 * sizeof (uint32_t));
+  int n = 0;
+  for (int c = 0; c < ncities; c++)
+    {
+    const char *f = folded[c];
+    for (int i = 0; f[i] && f[i + 1] && f[i + 2]; i++)
       {
-      if (!list) list = klist_new_empty ((KListFreeFn)NULL);
-      // Add to list
-      klist_append (list, c);
-      klog_debug (KLOG_CLASS, "Found '%s'", c->name);
+      pairs[2 * n] = solcity_trigram (f + i);
+      pairs[2 * n + 1] = c;
+      n++;
       }
-    i++;
-    c = &cities[i];
-    free (name);
     }
+  qsort (pairs, n, 2 * sizeof (uint32_t), solcity_compare_pairs);
+
+  trigrams = malloc (n * sizeof (Trigram));
+  postings = malloc (n * sizeof (int));
+  ntrigrams = 0;
+  int npostings = 0;
+  for (int i = 0; i < n; i++)
+    {
+    // A city can contain a trigram more than once
+    if (i > 0 && pairs[2 * i] == pairs[2 * i - 2] 
+        && pairs[2 * i + 1] == pairs[2 * i - 1]) continue;
+    if (ntrigrams == 0 || trigrams[ntrigrams - 1].trigram != pairs[2 * i])
+      {
+      trigrams[ntrigrams].trigram = pairs[2 * i];
+      trigrams[ntrigrams].start = npostings;
+      trigrams[ntrigrams].count = 0;
+      ntrigrams++;
+      }
+    postings[npostings++] = pairs[2 * i + 1];
+    trigrams[ntrigrams - 1].count++;
+    }
+  free (pairs);
 
-  free (slwr);
+  klog_debug (KLOG_CLASS, "City index: %d cities, %d trigrams", 
+    ncities, ntrigrams);
+  KLOG_OUT
+  }
+
+/*============================================================================
+  
+  solcity_match
+
+  Common part of the lookup functions. Returns the number of matches.
+
+  ==========================================================================*/
+static int solcity_match (const UTF8 *s, int *first, SolCityMatchFn fn, 
+     void *user_data)
+  {
+  char q[MAX_QUERY];
+  int len = solcity_fold ((const char *)s, q, sizeof (q));
+  *first = -1;
+  if (len < 0) return 0; // Longer than any city name
+
+  if (!fn)
+    {
+    const CityHashEntry *e = solcity_find_exact (q);
+    if (e)
+      {
+      *first = e->first;
+      return e->count;
+      }
+    }
+  pthread_once (&index_once, solcity_build_index);
+  return solcity_search (q, len, first, fn, user_data);
+  }
+
+/*============================================================================
+  
+  solcity_append_match
+
+  ==========================================================================*/
+static void solcity_append_match (const SolCity *city, void *user_data)
+  {
+  KList **list = user_data;
+  if (!*list) *list = klist_new_empty ((KListFreeFn)NULL);
+  klist_append (*list, (void *)city);
+  klog_debug (KLOG_CLASS, "Found '%s'", city->name);
+  }
+
+/*============================================================================
+  
+  solcity_find_matching 
+
+  ==========================================================================*/
+KList *solcity_find_matching (const UTF8 *s)
+  {
+  KLOG_IN
+  assert (s != NULL);
+  KList *list = NULL;
+  klog_debug (KLOG_CLASS, "Find city matching '%s'", s);
+  int first;
+  solcity_match (s, &first, solcity_append_match, &list);
   KLOG_OUT
   return list;
   }
 
+/*============================================================================
+  
+  solcity_find_unique
+
+  ==========================================================================*/
+int solcity_find_unique (const UTF8 *s, const SolCity **city)
+  {
+  KLOG_IN
+  assert (s != NULL);
+  int first;
+  int ret = solcity_match (s, &first, NULL, NULL);
+  *city = ret > 0 ? &cities[first] : NULL;
+  klog_debug (KLOG_CLASS, "Find city matching '%s': %d matches", s, ret);
+  KLOG_OUT
+  return ret;
+  }
+
 /*============================================================================
   
   solcity_get_latitude 
@@ -138,4 +441,226 @@ const char *solcity_get_tz_name (const SolCity *self)
   return ret;
   }
 
+/*============================================================================
+  
+  solcity_get_zone
+
+  The zone is looked up lazily and stored in the city entry. Two threads
+  might race to store it, but they will both store the same pointer,
+  because ktimezone_get() shares zone objects.
+
+  ==========================================================================*/
+const KTimeZone *solcity_get_zone (const SolCity *self)
+  {
+  KLOG_IN
+  SolCity *city = (SolCity *)self;
+  const KTimeZone *ret = __atomic_load_n (&city->zone, __ATOMIC_ACQUIRE);
+  if (!ret)
+    {
+    ret = ktimezone_get (city->tz_name);
+    if (!ret)
+      {
+      klog_warn (KLOG_CLASS, "Can't load timezone '%s'; using UTC", 
+        city->tz_name);
+      ret = ktimezone_get_utc ();
+      }
+    __atomic_store_n (&city->zone, ret, __ATOMIC_RELEASE);
+    }
+  KLOG_OUT
+  return ret;
+  }
+
+/*============================================================================
+  
+  solcity_preload_zones
+
+  ==========================================================================*/
+void solcity_preload_zones (void)
+  {
+  KLOG_IN
+  int i = 0;
+  SolCity *c = &cities[i];
+  while (c->name)
+    {
+    solcity_get_zone (c);
+    i++;
+    c = &cities[i];
+    }
+  klog_info (KLOG_CLASS, "Loaded timezones for %d cities", i);
+  KLOG_OUT
+  }
+
+/*============================================================================
+  
+  Spatial index
+
+  Cities are stored as points on the unit sphere, so that straight-line
+  distance between points increases with distance along the surface,
+  and there is no trouble at the poles or the date line. The points 
+  are arranged into an implicit k-d tree: in any range of the array,
+  the middle element is the node, it splits the others on one axis, and
+  the two halves of the range are its subtrees. The tree is built on 
+  first use.
+
+  ==========================================================================*/
+typedef struct _KDPoint
+  {
+  double v[3];
+  int city;
+  } KDPoint;
+
+static KDPoint *kd_points;
+static unsigned char *kd_axis; // Split axis of the node at each index
+static int kd_count;
+static int kd_sort_axis; // Only used during the build
+static pthread_once_t kd_once = PTHREAD_ONCE_INIT;
+
+/*============================================================================
+  
+  solcity_to_vector
+
+  ==========================================================================*/
+static void solcity_to_vector (double latitude, double longitude, 
+      double *v)
+  {
+  double lat = latitude * M_PI / 180.0;
+  double lon = longitude * M_PI / 180.0;
+  v[0] = cos (lat) * cos (lon);
+  v[1] = cos (lat) * sin (lon);
+  v[2] = sin (lat);
+  }
+
+/*============================================================================
+  
+  solcity_compare_points
+
+  ==========================================================================*/
+static int solcity_compare_points (const void *a, const void *b)
+  {
+  const KDPoint *pa = a;
+  const KDPoint *pb = b;
+  double da = pa->v[kd_sort_axis];
+  double db = pb->v[kd_sort_axis];
+  if (da != db) return da < db ? -1 : 1;
+  return pa->city - pb->city;
+  }
+
+/*============================================================================
+  
+  solcity_kd_build
+
+  Arrange points [lo, hi) into a subtree
+
+  ==========================================================================*/
+static void solcity_kd_build (int lo, int hi)
+  {
+  if (hi - lo < 1) return;
+
+  // Split on the axis along which the points are most spread out
+  double min[3] = { 2, 2, 2 };
+  double max[3] = { -2, -2, -2 };
+  for (int i = lo; i < hi; i++)
+    for (int a = 0; a < 3; a++)
+      {
+      if (kd_points[i].v[a] < min[a]) min[a] = kd_points[i].v[a];
+      if (kd_points[i].v[a] > max[a]) max[a] = kd_points[i].v[a];
+      }
+  int axis = 0;
+  for (int a = 1; a < 3; a++)
+    if (max[a] - min[a] > max[axis] - min[axis]) axis = a;
+
+  kd_sort_axis = axis;
+  qsort (kd_points + lo, hi - lo, sizeof (KDPoint), 
+    solcity_compare_points);
+  int mid = lo + (hi - lo) / 2;
+  kd_axis[mid] = axis;
+  solcity_kd_build (lo, mid);
+  solcity_kd_build (mid + 1, hi);
+  }
+
+/*============================================================================
+  
+  solcity_build_kd_tree
+
+  ==========================================================================*/
+static void solcity_build_kd_tree (void)
+  {
+  KLOG_IN
+  kd_count = 0;
+  while (cities[kd_count].name) kd_count++;
+  kd_points = malloc (kd_count * sizeof (KDPoint));
+  kd_axis = malloc (kd_count);
+  for (int i = 0; i < kd_count; i++)
+    {
+    solcity_to_vector (cities[i].latitude, cities[i].longitude, 
+      kd_points[i].v);
+    kd_points[i].city = i;
+    }
+  solcity_kd_build (0, kd_count);
+  klog_debug (KLOG_CLASS, "Built k-d tree of %d cities", kd_count);
+  KLOG_OUT
+  }
+
+/*============================================================================
+  
+  solcity_kd_search
+
+  Search the subtree in [lo, hi) for a point nearer to v than *best_d2
+  (a squared distance). Ties go to the city that comes first in the
+  table, so the result does not depend on the shape of the tree.
+
+  ==========================================================================*/
+static void solcity_kd_search (int lo, int hi, const double *v, 
+      int *best, double *best_d2)
+  {
+  if (hi - lo < 1) return;
+  int mid = lo + (hi - lo) / 2;
+  const KDPoint *p = &kd_points[mid];
+
+  double d2 = 0;
+  for (int a = 0; a < 3; a++)
+    {
+    double d = p->v[a] - v[a];
+    d2 += d * d;
+    }
+  if (d2 < *best_d2 || (d2 == *best_d2 && p->city < *best))
+    {
+    *best_d2 = d2;
+    *best = p->city;
+    }
+
+  int axis = kd_axis[mid];
+  double diff = v[axis] - p->v[axis];
+  if (diff < 0)
+    {
+    solcity_kd_search (lo, mid, v, best, best_d2);
+    if (diff * diff <= *best_d2) 
+      solcity_kd_search (mid + 1, hi, v, best, best_d2);
+    }
+  else
+    {
+    solcity_kd_search (mid + 1, hi, v, best, best_d2);
+    if (diff * diff <= *best_d2) 
+      solcity_kd_search (lo, mid, v, best, best_d2);
+    }
+  }
+
+/*============================================================================
+  
+  solcity_find_nearest
+
+  ==========================================================================*/
+const SolCity *solcity_find_nearest (double latitude, double longitude)
+  {
+  KLOG_IN
+  pthread_once (&kd_once, solcity_build_kd_tree);
+  double v[3];
+  solcity_to_vector (latitude, longitude, v);
+  int best = -1;
+  double best_d2 = 5.0; // Further than any two points on the sphere 
+  solcity_kd_search (0, kd_count, v, &best, &best_d2);
+  const SolCity *ret = best >= 0 ? &cities[best] : NULL;
+  KLOG_OUT
+  return ret;
+  }
 
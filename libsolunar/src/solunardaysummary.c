@@ -15,6 +15,7 @@
 #include <memory.h>
 #include <assert.h>
 #include <math.h>
+#include <time.h>
 #include <libsolunar/solunardaysummary.h>
 #include <libsolunar/suntimes.h>
 #include <libsolunar/sunephemera.h>
@@ -54,20 +55,39 @@ struct _SolunarDaySummary
   const char *moon_phase_name;
   char *city;
   char *tz_city;
+  const KTimeZone *zone; // NULL means local time
   double longitude;
   double latitude;
   time_t date;
+  const char *sun_time_format; // "24hr_secs" if worked out to the second
+  uint64_t sun_ns;  // Time taken by the sun calculations
+  uint64_t moon_ns; // Time taken by the moon calculations
   };
 
+/*============================================================================
+ 
+  solunar_day_summary_now
+
+  ==========================================================================*/
+static uint64_t solunar_day_summary_now (void)
+  {
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+  }
+
 
 /*============================================================================
  
-  solunar_day_summary_create 
+  solunar_day_summary_create_internal
+
+  tz is the name stored for display, and zone the zone object used for
+  conversions. They usually, but not always, describe the same zone.
 
   ==========================================================================*/
-SolunarDaySummary *solunar_day_summary_create 
+static SolunarDaySummary *solunar_day_summary_create_internal 
         (time_t date, double latitude, double longitude, const char *city, 
-	  const char *tz)
+	  const char *tz, const KTimeZone *zone)
   {
   KLOG_IN
   SolunarDaySummary *self = malloc (sizeof (SolunarDaySummary));
@@ -76,39 +96,30 @@ SolunarDaySummary *solunar_day_summary_create
   self->longitude = longitude;
   self->latitude = latitude;
   self->date = date;
+  self->zone = zone;
+
+  uint64_t t0 = solunar_day_summary_now ();
+
+  // All the rises and sets share the sun's position, so they are
+  //  worked out together
+  static const double zeniths[4] = {SUNTIMES_DEFAULT_ZENITH, 
+    SUNTIMES_CIVIL_TWILIGHT, SUNTIMES_NAUTICAL_TWILIGHT, 
+    SUNTIMES_ASTRONOMICAL_TWILIGHT};
+  time_t rises[4], sets[4];
+  self->sun_time_format = 
+    suntimes_get_solver () == SUNTIMES_PRECISE ? "24hr_secs" : "24hr";
+  suntimes_get_sun_events (date, latitude, longitude, zeniths, 4, 
+    rises, sets);
+
+  self->sunrise = rises[0];
+  self->sunset = sets[0];
+  self->start_civil_twilight = rises[1];
+  self->end_civil_twilight = sets[1];
+  self->start_nautical_twilight = rises[2];
+  self->end_nautical_twilight = sets[2];
+  self->start_astronomical_twilight = rises[3];
+  self->end_astronomical_twilight = sets[3];
 
-  self->sunrise = suntimes_get_sunrise 
-	  (date, latitude, longitude, SUNTIMES_DEFAULT_ZENITH);
-
-  self->sunset = suntimes_get_sunset
-	  (date, latitude, longitude, SUNTIMES_DEFAULT_ZENITH);
-
-  self->end_civil_twilight = suntimes_get_sunset
-	  (date, latitude, longitude, SUNTIMES_CIVIL_TWILIGHT);
-
-  self->end_nautical_twilight = suntimes_get_sunset
-	  (date, latitude, longitude, SUNTIMES_NAUTICAL_TWILIGHT);
-
-  self->end_astronomical_twilight = suntimes_get_sunset
-	  (date, latitude, longitude, SUNTIMES_ASTRONOMICAL_TWILIGHT);
-
-  self->start_civil_twilight = suntimes_get_sunrise
-	  (date, latitude, longitude, SUNTIMES_CIVIL_TWILIGHT);
-
-  self->start_nautical_twilight = suntimes_get_sunrise
-	  (date, latitude, longitude, SUNTIMES_NAUTICAL_TWILIGHT);
-
-  self->start_astronomical_twilight = suntimes_get_sunrise
-	  (date, latitude, longitude, SUNTIMES_ASTRONOMICAL_TWILIGHT);
-
-  time_t tstart = datetimeconv_make_time_on_day (date, 0, 0, 0, tz);
-  time_t tend = datetimeconv_make_time_on_day (date, 23, 59, 0, tz);
-
-  moontimes_get_moonrises (tstart, tend, latitude, longitude, 
-    self->moonrises, N_MOON_EVENTS, &self->nrises); 
-  moontimes_get_moonsets (tstart, tend, latitude, longitude, 
-    self->moonsets, N_MOON_EVENTS, &self->nsets); 
-  
   // In principle, this calculation should take into account the
   //  fact that the Earth moves in its orbit between sunrise and
   //  sunset. It's not as simple a calculation as this. But the
@@ -125,10 +136,23 @@ SolunarDaySummary *solunar_day_summary_create
   else
     klog_warn (KLOG_CLASS, "Sun sine altitude not in range -1..1");
 
+  uint64_t t1 = solunar_day_summary_now ();
+
+  time_t tstart = datetimeconv_make_time_on_day_in_zone (date, 0, 0, 0, zone);
+  time_t tend = datetimeconv_make_time_on_day_in_zone (date, 23, 59, 0, zone);
+
+  moontimes_get_moon_events (tstart, tend, latitude, longitude, 
+    self->moonrises, N_MOON_EVENTS, &self->nrises,
+    self->moonsets, N_MOON_EVENTS, &self->nsets); 
+
   moonephemera_get_moon_state (latitude, longitude, date, 
        &self->moon_phase_name, &self->moon_phase, &self->moon_age, 
        &self->moon_distance);
 
+  uint64_t t2 = solunar_day_summary_now ();
+  self->sun_ns = t1 - t0;
+  self->moon_ns = t2 - t1;
+
   if (tz) self->tz_city = strdup (tz);
   if (city) self->city = strdup (city);
 
@@ -136,6 +160,45 @@ SolunarDaySummary *solunar_day_summary_create
   return self;
   }
 
+/*============================================================================
+ 
+  solunar_day_summary_create 
+
+  ==========================================================================*/
+SolunarDaySummary *solunar_day_summary_create 
+        (time_t date, double latitude, double longitude, const char *city, 
+	  const char *tz)
+  {
+  KLOG_IN
+  const KTimeZone *zone = NULL;
+  if (tz)
+    {
+    zone = ktimezone_get (tz);
+    if (!zone) zone = ktimezone_get_utc ();
+    }
+  SolunarDaySummary *self = solunar_day_summary_create_internal 
+    (date, latitude, longitude, city, tz, zone);
+  KLOG_OUT
+  return self;
+  }
+
+/*============================================================================
+ 
+  solunar_day_summary_create_in_zone
+
+  ==========================================================================*/
+SolunarDaySummary *solunar_day_summary_create_in_zone
+        (time_t date, double latitude, double longitude, const char *city, 
+	  const KTimeZone *zone)
+  {
+  KLOG_IN
+  const char *tz = zone ? ktimezone_get_name (zone) : NULL;
+  SolunarDaySummary *self = solunar_day_summary_create_internal 
+    (date, latitude, longitude, city, tz, zone);
+  KLOG_OUT
+  return self;
+  }
+
 /*============================================================================
  
   solunar_day_summary_destroy
@@ -153,6 +216,21 @@ void solunar_day_summary_destroy (SolunarDaySummary *self)
   KLOG_OUT
   }
 
+/*============================================================================
+ 
+  solunar_day_summary_get_timings
+
+  ==========================================================================*/
+void solunar_day_summary_get_timings (const SolunarDaySummary *self, 
+       uint64_t *sun_ns, uint64_t *moon_ns)
+  {
+  KLOG_IN
+  assert (self != NULL);
+  if (sun_ns) *sun_ns = self->sun_ns;
+  if (moon_ns) *moon_ns = self->moon_ns;
+  KLOG_OUT
+  }
+
 /*============================================================================
  
   solunar_day_summary_get_city
@@ -480,141 +558,122 @@ extern double solunar_day_summary_get_sun_max_altitude
 
 /*============================================================================
  
-  solunar_day_summary_to_json
+  solunar_day_summary_write_time
+
+  Write a member whose value is a time of day, if the time is set. 
+  fmt is "24hr" (HH:MM) or "24hr_secs" (HH:MM:SS)
 
   ==========================================================================*/
-KString *solunar_day_summary_to_json (const SolunarDaySummary *self)
+static void solunar_day_summary_write_time (const SolunarDaySummary *self,
+       KJsonWriter *w, const char *key, const char *fmt, time_t t)
   {
-  KLOG_IN
-  assert (self != NULL);
-  KString *json = kstring_new_empty(); 
-  kstring_append_printf (json, "{");
-
-  const char *city = self->city;
-  if (city)
-    kstring_append_printf (json, "\"city\":\"%s\",\n", city);
-  const char *tz_city = self->tz_city;
-  kstring_append_printf (json, "\"timezone city\":\"%s\",\n", tz_city);
-  kstring_append_printf (json, "\"latitude\":%g,\n", self->latitude);
-  char *s = datetimeconv_format_time ("short_date", tz_city, self->date);
-  kstring_append_printf (json, "\"longitude\":%g,\n", self->longitude);
-  kstring_append_printf (json, "\"date\":\"%s\",\n", s);
-  free (s);
-  kstring_append_printf (json, "\"sun\":{");
-
-  if (self->sunrise)
-    {
-    char *s = datetimeconv_format_time ("24hr", tz_city, self->sunrise);
-    kstring_append_printf (json, "\"sunrise\":\"%s\",\n", s);
-    free (s);
-    }
-  if (self->sunset)
-    {
-    char *s = datetimeconv_format_time ("24hr", tz_city, self->sunset);
-    kstring_append_printf (json, "\"sunset\":\"%s\",\n", s);
-    free (s);
-    }
-  if (self->start_civil_twilight)
-    {
-    char *s = datetimeconv_format_time ("24hr", tz_city, 
-      self->start_civil_twilight);
-    kstring_append_printf (json, "\"start civil twilight\":\"%s\",\n", s);
-    free (s);
-    }
-  if (self->end_civil_twilight)
-    {
-    char *s = datetimeconv_format_time ("24hr", tz_city, 
-      self->end_civil_twilight);
-    kstring_append_printf (json, "\"end civil twilight\":\"%s\",\n", s);
-    free (s);
-    }
-  if (self->start_nautical_twilight)
-    {
-    char *s = datetimeconv_format_time ("24hr", tz_city, 
-      self->start_nautical_twilight);
-    kstring_append_printf (json, "\"start nautical twilight\":\"%s\",\n", s);
-    free (s);
-    }
-  if (self->end_nautical_twilight)
-    {
-    char *s = datetimeconv_format_time ("24hr", tz_city, 
-      self->end_nautical_twilight);
-    kstring_append_printf (json, "\"end nautical twilight\":\"%s\",\n", s);
-    free (s);
-    }
-  if (self->start_astronomical_twilight)
-    {
-    char *s = datetimeconv_format_time ("24hr", tz_city, 
-      self->start_astronomical_twilight);
-    kstring_append_printf (json, "\"start astronomical twilight\":\"%s\",\n", s);
-    free (s);
-    }
-  if (self->end_astronomical_twilight)
-    {
-    char *s = datetimeconv_format_time ("24hr", tz_city, 
-      self->end_astronomical_twilight);
-    kstring_append_printf (json, "\"end astronomical twilight\":\"%s\",\n", s);
-    free (s);
-    }
-  if (self->high_noon)
+  if (t)
     {
-    char *s = datetimeconv_format_time ("24hr", tz_city, 
-      self->high_noon);
-    kstring_append_printf (json, "\"high noon\":\"%s\",\n", s);
-    free (s);
-    kstring_append_printf (json, "\"sun altitude at high noon\":%g,\n", 
-       self->sun_max_altitude);
+    char s[32];
+    datetimeconv_format_time_in_zone_buff (fmt, self->zone, t, 
+      s, sizeof (s));
+    if (key) kjsonwriter_key (w, key);
+    kjsonwriter_string (w, s);
     }
+  }
 
-  if (kstring_ends_with_utf8 (json, (UTF8 *)",\n"))
-    {
-    int l = kstring_length (json);
-    kstring_delete (json, l - 2, 2);
-    }
-
-  kstring_append_printf (json, "},\n");
-
-  kstring_append_printf (json, "\"moon\":{");
+/*============================================================================
+ 
+  solunar_day_summary_write_json
 
-  kstring_append_printf (json, "\"rises\":[");
-  int nrises = self->nrises; 
-  for (int i = 0; i < nrises; i++)
-    {
-    char *s = datetimeconv_format_time ("24hr", tz_city, 
-	   self->moonrises[i]); 
-    kstring_append_printf (json, "\"%s\",", s);
-    free (s);
-    }
+  ==========================================================================*/
+void solunar_day_summary_write_json (const SolunarDaySummary *self,
+       KJsonWriter *w, int flags)
+  {
+  KLOG_IN
+  assert (self != NULL);
+  kjsonwriter_begin_object (w, flags);
 
-  if (kstring_ends_with_utf8 (json, (UTF8 *)","))
+  if (self->city)
     {
-    int l = kstring_length (json);
-    kstring_delete (json, l - 1, 1);
+    kjsonwriter_key (w, "city");
+    kjsonwriter_string (w, self->city);
     }
-  kstring_append_printf (json, "],\n");
-
-  kstring_append_printf (json, "\"sets\":[");
-  int nsets = self->nsets; 
-  for (int i = 0; i < nsets; i++)
+  kjsonwriter_key (w, "timezone city");
+  kjsonwriter_string (w, self->tz_city);
+  kjsonwriter_key (w, "latitude");
+  kjsonwriter_number (w, self->latitude);
+  kjsonwriter_key (w, "longitude");
+  kjsonwriter_number (w, self->longitude);
+  char s[32];
+  datetimeconv_format_time_in_zone_buff ("short_date", self->zone, 
+    self->date, s, sizeof (s));
+  kjsonwriter_key (w, "date");
+  kjsonwriter_string (w, s);
+
+  kjsonwriter_key (w, "sun");
+  kjsonwriter_begin_object (w, flags);
+  solunar_day_summary_write_time (self, w, "sunrise", self->sun_time_format, 
+    self->sunrise);
+  solunar_day_summary_write_time (self, w, "sunset", self->sun_time_format, 
+    self->sunset);
+  solunar_day_summary_write_time (self, w, "start civil twilight", 
+    self->sun_time_format, self->start_civil_twilight);
+  solunar_day_summary_write_time (self, w, "end civil twilight", 
+    self->sun_time_format, self->end_civil_twilight);
+  solunar_day_summary_write_time (self, w, "start nautical twilight", 
+    self->sun_time_format, self->start_nautical_twilight);
+  solunar_day_summary_write_time (self, w, "end nautical twilight", 
+    self->sun_time_format, self->end_nautical_twilight);
+  solunar_day_summary_write_time (self, w, "start astronomical twilight", 
+    self->sun_time_format, self->start_astronomical_twilight);
+  solunar_day_summary_write_time (self, w, "end astronomical twilight", 
+    self->sun_time_format, self->end_astronomical_twilight);
+  if (self->high_noon)
     {
-    char *s = datetimeconv_format_time ("24hr", tz_city, 
-	   self->moonsets[i]); 
-    kstring_append_printf (json, "\"%s\",", s);
-    free (s);
+    solunar_day_summary_write_time (self, w, "high noon", 
+      self->sun_time_format, self->high_noon);
+    kjsonwriter_key (w, "sun altitude at high noon");
+    kjsonwriter_number (w, self->sun_max_altitude);
     }
+  kjsonwriter_end_object (w);
+
+  kjsonwriter_key (w, "moon");
+  kjsonwriter_begin_object (w, flags);
+  kjsonwriter_key (w, "rises");
+  kjsonwriter_begin_array (w, 0);
+  for (int i = 0; i < self->nrises; i++)
+    solunar_day_summary_write_time (self, w, NULL, "24hr", 
+      self->moonrises[i]);
+  kjsonwriter_end_array (w);
+  kjsonwriter_key (w, "sets");
+  kjsonwriter_begin_array (w, 0);
+  for (int i = 0; i < self->nsets; i++)
+    solunar_day_summary_write_time (self, w, NULL, "24hr", 
+      self->moonsets[i]);
+  kjsonwriter_end_array (w);
+  kjsonwriter_key (w, "moon phase name");
+  kjsonwriter_string (w, self->moon_phase_name);
+  kjsonwriter_key (w, "moon phase");
+  kjsonwriter_number (w, self->moon_phase);
+  kjsonwriter_key (w, "moon age");
+  kjsonwriter_number (w, self->moon_age);
+  if (flags & KJSONWRITER_NEWLINES) kjsonwriter_newline (w);
+  kjsonwriter_end_object (w);
+
+  kjsonwriter_end_object (w);
+  KLOG_OUT
+  }
 
-  if (kstring_ends_with_utf8 (json, (UTF8 *)","))
-    {
-    int l = kstring_length (json);
-    kstring_delete (json, l - 1, 1);
-    }
-  kstring_append_printf (json, "],\n");
-  kstring_append_printf (json, "\"moon phase name\":\"%s\",\n", self->moon_phase_name);
-  kstring_append_printf (json, "\"moon phase\":%g,\n", self->moon_phase);
-  kstring_append_printf (json, "\"moon age\":%g\n", self->moon_age);
+/*============================================================================
+ 
+  solunar_day_summary_to_json
 
-  kstring_append_printf (json, "}");
-  kstring_append_printf (json, "}");
+  ==========================================================================*/
+KString *solunar_day_summary_to_json (const SolunarDaySummary *self)
+  {
+  KLOG_IN
+  char buff[2048];
+  KJsonWriter *w = kjsonwriter_new_with_buffer (buff, sizeof (buff));
+  solunar_day_summary_write_json (self, w, KJSONWRITER_NEWLINES);
+  KString *json = kstring_new_from_utf8 
+    ((const UTF8 *)kjsonwriter_get_data (w));
+  kjsonwriter_destroy (w);
   KLOG_OUT
   return json; 
   }
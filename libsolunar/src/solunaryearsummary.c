@@ -32,55 +32,54 @@ struct _SolunarYearSummary
   KList *list;
   int year;
   double latitude;
-  char *tz;
+  const KTimeZone *zone; // NULL means local time
   };
 
 
 /*============================================================================
  
-  solunar_year_summary_create 
+  solunar_year_summary_create_in_zone
 
   ==========================================================================*/
-SolunarYearSummary *solunar_year_summary_create 
-        (int year, double latitude, const char *tz)
+SolunarYearSummary *solunar_year_summary_create_in_zone
+        (int year, double latitude, const KTimeZone *zone)
   {
   KLOG_IN
   SolunarYearSummary *self = malloc (sizeof (SolunarYearSummary));
   memset (self, 0, sizeof (SolunarYearSummary));
 
-  if (tz)
-    self->tz = strdup (tz);
+  self->zone = zone;
   self->latitude = latitude;
   self->year = year;
 
   self->list = klist_new_empty ((KListFreeFn) festival_destroy);
 
   klist_append (self->list, 
-    festival_get_shrove_tuesday (year, tz));
+    festival_get_shrove_tuesday (year, zone));
 
   klist_append (self->list, 
-    festival_get_ash_wednesday (year, tz));
+    festival_get_ash_wednesday (year, zone));
 
   klist_append (self->list, 
-    festival_get_mothering_sunday (year, tz));
+    festival_get_mothering_sunday (year, zone));
 
   klist_append (self->list, 
-    festival_get_palm_sunday (year, tz));
+    festival_get_palm_sunday (year, zone));
 
   klist_append (self->list, 
-    festival_get_maundy_thursday (year, tz));
+    festival_get_maundy_thursday (year, zone));
 
   klist_append (self->list, 
-    festival_get_good_friday (year, tz));
+    festival_get_good_friday (year, zone));
 
   klist_append (self->list, 
-    festival_get_easter_sunday (year, tz));
+    festival_get_easter_sunday (year, zone));
 
   klist_append (self->list, 
-    festival_get_easter_monday (year, tz));
+    festival_get_easter_monday (year, zone));
 
   klist_append (self->list, 
-    festival_get_whitsun (year, tz));
+    festival_get_whitsun (year, zone));
 
   klist_append (self->list, 
     festival_get_vernal_equinox (year));
@@ -99,6 +98,27 @@ SolunarYearSummary *solunar_year_summary_create
   return self;
   }
 
+/*============================================================================
+ 
+  solunar_year_summary_create 
+
+  ==========================================================================*/
+SolunarYearSummary *solunar_year_summary_create 
+        (int year, double latitude, const char *tz)
+  {
+  KLOG_IN
+  const KTimeZone *zone = NULL;
+  if (tz)
+    {
+    zone = ktimezone_get (tz);
+    if (!zone) zone = ktimezone_get_utc ();
+    }
+  SolunarYearSummary *self = solunar_year_summary_create_in_zone 
+    (year, latitude, zone);
+  KLOG_OUT
+  return self;
+  }
+
 /*============================================================================
  
   solunar_year_summary_destroy
@@ -110,7 +130,6 @@ void solunar_year_summary_destroy (SolunarYearSummary *self)
   if (self)
     {
     if (self->list) klist_destroy (self->list);
-    if (self->tz) free (self->tz);
     free (self);
     }
   KLOG_OUT
@@ -118,46 +137,63 @@ void solunar_year_summary_destroy (SolunarYearSummary *self)
 
 /*============================================================================
  
-  solunar_year_summary_to_json
+  solunar_year_summary_write_json
 
   ==========================================================================*/
-KString *solunar_year_summary_to_json (const SolunarYearSummary *self)
+void solunar_year_summary_write_json (const SolunarYearSummary *self,
+       KJsonWriter *w)
   {
   KLOG_IN
   assert (self != NULL);
-  KString *json = kstring_new_empty();
   int l = klist_length (self->list); 
-  kstring_append_utf8 (json, (UTF8 *)"[");
+  kjsonwriter_begin_array (w, KJSONWRITER_NEWLINES);
   for (int i = 0; i < l; i++)
     {
     Festival *f = klist_get (self->list, i);
-    kstring_append_utf8 (json, (UTF8 *)"{");
     const char *name = festival_get_name (f);
     time_t date = festival_get_date (f);
 
+    // Dates are shown in the summary's zone, not the server's
     struct tm tm;
-    localtime_r (&date, &tm);  
+    if (self->zone)
+      ktimezone_utc_to_local (self->zone, date, &tm);
+    else
+      localtime_r (&date, &tm);  
 
-    KString *ds = kstring_new_empty();
-    kstring_append_printf (ds, "%04d-%02d-%02d", 
+    char ds[32];
+    int n = snprintf (ds, sizeof (ds), "%04d-%02d-%02d", 
       tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday); 
-        
     if (festival_has_time (f))
       {
-      kstring_append_printf (ds, " (%02d:%02d)", tm.tm_hour, tm.tm_min);
+      snprintf (ds + n, sizeof (ds) - n, " (%02d:%02d)", 
+        tm.tm_hour, tm.tm_min);
       }
 
-    kstring_append_printf (json, "\"name\":\"%s\",", name); 
-    kstring_append_utf8 (json, (UTF8 *)"\"date\":\"");
-    kstring_append (json, ds); 
-    kstring_append_utf8 (json, (UTF8 *)"\"");
-    kstring_destroy (ds);
-    kstring_append_utf8 (json, (UTF8 *)"}");
-    if (i != l - 1)
-      kstring_append_utf8 (json, (UTF8 *)",\n");
+    kjsonwriter_begin_object (w, 0);
+    kjsonwriter_key (w, "name");
+    kjsonwriter_string (w, name);
+    kjsonwriter_key (w, "date");
+    kjsonwriter_string (w, ds);
+    kjsonwriter_end_object (w);
     }
+  kjsonwriter_end_array (w);
+  kjsonwriter_newline (w);
+  KLOG_OUT
+  }
 
-  kstring_append_utf8 (json, (UTF8 *)"]\n");
+/*============================================================================
+ 
+  solunar_year_summary_to_json
+
+  ==========================================================================*/
+KString *solunar_year_summary_to_json (const SolunarYearSummary *self)
+  {
+  KLOG_IN
+  KJsonWriter *w = kjsonwriter_new ();
+  solunar_year_summary_write_json (self, w);
+  KString *json = kstring_new_from_utf8 
+    ((const UTF8 *)kjsonwriter_get_data (w));
+  kjsonwriter_destroy (w);
   KLOG_OUT
   return json;
   }
@@ -178,7 +214,7 @@ KString *solunar_year_summary_to_string (const SolunarYearSummary *self)
   for (int i = 0; i < l; i++)
     {
     Festival *f = klist_get (self->list, i);
-    KString *ss = festival_to_string (f, self->tz);
+    KString *ss = festival_to_string (f, self->zone);
     kstring_append (s, ss); 
     kstring_append_utf8 (s, (UTF8 *)"\n"); 
     kstring_destroy (ss);
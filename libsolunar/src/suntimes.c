@@ -16,6 +16,7 @@
 #include <math.h>
 #include <libsolunar/suntimes.h>
 #include <libsolunar/astroutil.h>
+#include <libsolunar/sunephemera.h>
 #include <klib/klog.h>
 
 static const double DEG_PER_HOUR = 360.0 / 24.0;
@@ -23,6 +24,11 @@ static const double TWO_PI = 2.0 * M_PI;
 
 #define KLOG_CLASS "libsolunar.suntimes"
 
+// The most corrections that SUNTIMES_PRECISE will make to an event
+#define MAX_REFINE_STEPS 8
+
+static SunTimesSolver solver = SUNTIMES_APPROXIMATE;
+
 /*============================================================================
   
   suntimes_get_approx_sunrise_time
@@ -117,49 +123,86 @@ double suntimes_get_sun_mean_anomaly_at_sunset (int doy, double longitude)
 
 /*============================================================================
   
-  suntimes_get_sunrise
+  SunPosition
+
+  The terms of the sun's position, around the time of sunrise or 
+  sunset, that the times of the events depend on. They do not depend
+  on the zenith, so one set serves for sunrise and all the twilights.
 
   ==========================================================================*/
-time_t suntimes_get_sunrise (time_t day, double latitude, double longitude, 
-       double zenith)
+typedef struct _SunPosition
+  {
+  double rah; // Right ascension, in hours
+  double sin_dec; // Sine and cosine of the declination
+  double cos_dec;
+  double approx_time; // Estimated time of the event, in days
+  } SunPosition;
+
+/*============================================================================
+  
+  suntimes_get_position
+
+  ==========================================================================*/
+static void suntimes_get_position (int doy, double longitude, BOOL rising,
+       SunPosition *pos)
   {
   KLOG_IN
+  double sma = rising 
+    ? suntimes_get_sun_mean_anomaly_at_sunrise (doy, longitude)
+    : suntimes_get_sun_mean_anomaly_at_sunset (doy, longitude);
 
-  struct tm tm_day;
-  gmtime_r (&day, &tm_day);
-  int doy = tm_day.tm_yday + 1;
+  double stl = suntimes_get_sun_true_longitude (sma);
 
-  time_t ret = (time_t)0; // Let's hope that the Sun doesn't set in
-                          //  1970 again ;)
+  pos->rah = suntimes_get_sun_ra_hours (stl);
+  pos->sin_dec = 0.39782 * mathutil_sin_deg (stl);
+  pos->cos_dec = mathutil_cos_deg (mathutil_asin_deg (pos->sin_dec));
 
-  double sma = suntimes_get_sun_mean_anomaly_at_sunrise (doy, longitude);
+  // It looks odd to pass hours as a longitude, but that's how the
+  //  times have always been worked out
+  double hours = astroutil_get_hours_from_meridian (longitude);
+  pos->approx_time = rising 
+    ? suntimes_get_approx_sunrise_time (doy, hours) 
+    : suntimes_get_approx_sunset_time (doy, hours);
+  KLOG_OUT
+  }
 
-  double stl = suntimes_get_sun_true_longitude (sma);
+/*============================================================================
+  
+  suntimes_get_event
 
-  double rah = suntimes_get_sun_ra_hours (stl);
+  Get the time at which the sun, at the specified position, crosses 
+  the zenith, or zero if it does not. midnight is the start of the UTC 
+  day, and hours the observer's offset from the meridian. The time is 
+  to the minute.
+
+  ==========================================================================*/
+static time_t suntimes_get_event (time_t midnight, const SunPosition *pos,
+       double sin_lat, double cos_lat, double hours, double zenith,
+       BOOL rising)
+  {
+  KLOG_IN
+  time_t ret = (time_t)0; // Let's hope that the Sun doesn't set in
+                          //  1970 again ;)
 
-  double clha = suntimes_get_cos_local_hour_angle (stl, latitude, zenith);
+  double clha = (mathutil_cos_deg (zenith) - (pos->sin_dec * sin_lat)) 
+        / (pos->cos_dec * cos_lat);
 
   if (clha >= -1 && clha <= 1)
     {
-    double lha = 360.0 - mathutil_acos_deg (clha);
+    double lha = mathutil_acos_deg (clha);
+    if (rising) lha = 360.0 - lha;
     double lh = lha / DEG_PER_HOUR;
-    double lmt = suntimes_get_local_mean_time (lh, rah, 
-      suntimes_get_approx_sunrise_time (doy, 
-         astroutil_get_hours_from_meridian (longitude)));
+    double lmt = suntimes_get_local_mean_time (lh, pos->rah, 
+      pos->approx_time);
 
-    double temp = lmt - astroutil_get_hours_from_meridian (longitude);
+    double temp = lmt - hours;
     if (temp < 0) temp += 24;
     if (temp > 24) temp -= 24;
 
     int utc_h = (int) temp;
     int utc_m = (int) ((temp - utc_h) * 60);
 
-    tm_day.tm_hour = utc_h;
-    tm_day.tm_min = utc_m;
-    tm_day.tm_sec = 0;
-
-    ret = timegm (&tm_day);
+    ret = midnight + utc_h * 3600 + utc_m * 60;
     }
 
   KLOG_OUT
@@ -168,51 +211,137 @@ time_t suntimes_get_sunrise (time_t day, double latitude, double longitude,
 
 /*============================================================================
   
-  suntimes_get_sunset
+  suntimes_refine_event
+
+  Starting from an estimate of the time at which the sun reaches the
+  specified zenith angle, repeatedly work out the sun's position at the
+  estimated time, and the hour angle at which a sun in that position 
+  would be at that zenith angle, and move the estimate by the difference
+  between that and the sun's actual hour angle, until the move is no 
+  more than a second. The sun's position changes little during the 
+  correction, so this usually takes two or three steps. If the sun only
+  just reaches the zenith angle, so that at some step it does not reach
+  it at all, or the estimate does not settle, the original estimate is
+  returned.
 
   ==========================================================================*/
-time_t suntimes_get_sunset (time_t day, double latitude, double longitude, 
-       double zenith)
+static time_t suntimes_refine_event (time_t estimate, double latitude, 
+       double longitude, double zenith, BOOL rising)
+  {
+  KLOG_IN
+  double cos_zenith = mathutil_cos_deg (zenith);
+  double sin_lat = mathutil_sin_deg (latitude);
+  double cos_lat = mathutil_cos_deg (latitude);
+  time_t t = estimate;
+  time_t ret = estimate;
+  for (int i = 0; i < MAX_REFINE_STEPS; i++)
+    {
+    double ra, dec;
+    sunephemera_get_ra_and_dec (t, &ra, &dec);
+    double clha = (cos_zenith - sin_lat * mathutil_sin_deg (dec)) 
+        / (cos_lat * mathutil_cos_deg (dec));
+    if (clha < -1 || clha > 1) break;
+
+    double target = mathutil_acos_deg (clha);
+    if (rising) target = -target;
+    double ha = DEG_PER_HOUR * (astroutil_lmst (t, longitude) - ra);
+    double diff = target - ha;
+    diff -= 360.0 * floor ((diff + 180.0) / 360.0); // -180..180
+
+    // The hour angle increases by 360 degrees in a solar day
+    time_t step = (time_t) floor (diff / 360.0 * 86400.0 + 0.5);
+    t += step;
+    if (step >= -1 && step <= 1)
+      {
+      ret = t;
+      break;
+      }
+    }
+  KLOG_OUT
+  return ret;
+  }
+
+/*============================================================================
+  
+  suntimes_get_sun_events
+
+  ==========================================================================*/
+void suntimes_get_sun_events (time_t day, double latitude, double longitude,
+       const double *zeniths, int n, time_t *rises, time_t *sets)
   {
   KLOG_IN
 
   struct tm tm_day;
   gmtime_r (&day, &tm_day);
   int doy = tm_day.tm_yday + 1;
+  tm_day.tm_hour = 0;
+  tm_day.tm_min = 0;
+  tm_day.tm_sec = 0;
+  time_t midnight = timegm (&tm_day);
 
-  time_t ret = (time_t)0; // Let's hope that the Sun doesn't set in
-                          //  1970 again ;)
-
-  double sma = suntimes_get_sun_mean_anomaly_at_sunset (doy, longitude);
-
-  double stl = suntimes_get_sun_true_longitude (sma);
-
-  double rah = suntimes_get_sun_ra_hours (stl);
+  double sin_lat = mathutil_sin_deg (latitude);
+  double cos_lat = mathutil_cos_deg (latitude);
+  double hours = astroutil_get_hours_from_meridian (longitude);
 
-  double clha = suntimes_get_cos_local_hour_angle (stl, latitude, zenith);
+  if (rises)
+    {
+    SunPosition pos;
+    suntimes_get_position (doy, longitude, TRUE, &pos);
+    for (int i = 0; i < n; i++)
+      {
+      rises[i] = suntimes_get_event (midnight, &pos, sin_lat, cos_lat, 
+        hours, zeniths[i], TRUE);
+      if (solver == SUNTIMES_PRECISE && rises[i])
+        rises[i] = suntimes_refine_event (rises[i], latitude, longitude,
+          zeniths[i], TRUE);
+      }
+    }
 
-  if (clha >= -1 && clha <= 1)
+  if (sets)
     {
-    double lha = mathutil_acos_deg (clha);
-    double lh = lha / DEG_PER_HOUR;
-    double lmt = suntimes_get_local_mean_time (lh, rah, 
-      suntimes_get_approx_sunset_time (doy, 
-         astroutil_get_hours_from_meridian (longitude)));
+    SunPosition pos;
+    suntimes_get_position (doy, longitude, FALSE, &pos);
+    for (int i = 0; i < n; i++)
+      {
+      sets[i] = suntimes_get_event (midnight, &pos, sin_lat, cos_lat, 
+        hours, zeniths[i], FALSE);
+      if (solver == SUNTIMES_PRECISE && sets[i])
+        sets[i] = suntimes_refine_event (sets[i], latitude, longitude,
+          zeniths[i], FALSE);
+      }
+    }
 
-    double temp = lmt - astroutil_get_hours_from_meridian (longitude);
-    if (temp < 0) temp += 24;
-    if (temp > 24) temp -= 24;
+  KLOG_OUT
+  }
 
-    int utc_h = (int) temp;
-    int utc_m = (int) ((temp - utc_h) * 60);
+/*============================================================================
+  
+  suntimes_get_sunrise
 
-    tm_day.tm_hour = utc_h;
-    tm_day.tm_min = utc_m;
-    tm_day.tm_sec = 0;
+  ==========================================================================*/
+time_t suntimes_get_sunrise (time_t day, double latitude, double longitude, 
+       double zenith)
+  {
+  KLOG_IN
+  time_t ret;
+  suntimes_get_sun_events (day, latitude, longitude, &zenith, 1, 
+    &ret, NULL);
+  KLOG_OUT
+  return ret;
+  }
 
-    ret = timegm (&tm_day);
-    }
+/*============================================================================
+  
+  suntimes_get_sunset
 
+  ==========================================================================*/
+time_t suntimes_get_sunset (time_t day, double latitude, double longitude, 
+       double zenith)
+  {
+  KLOG_IN
+  time_t ret;
+  suntimes_get_sun_events (day, latitude, longitude, &zenith, 1, 
+    NULL, &ret);
   KLOG_OUT
   return ret;
   }
@@ -258,3 +387,28 @@ double suntimes_get_sun_true_longitude (double angle)
   return l;
   }
 
+/*============================================================================
+  
+  suntimes_set_solver
+
+  ==========================================================================*/
+void suntimes_set_solver (SunTimesSolver s)
+  {
+  KLOG_IN
+  solver = s;
+  KLOG_OUT
+  }
+
+/*============================================================================
+  
+  suntimes_get_solver
+
+  ==========================================================================*/
+SunTimesSolver suntimes_get_solver (void)
+  {
+  KLOG_IN
+  SunTimesSolver ret = solver;
+  KLOG_OUT
+  return ret;
+  }
+
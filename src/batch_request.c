@@ -0,0 +1,384 @@
+/*============================================================================
+  
+  solunar_ws 
+  
+  batch_request.c
+
+  A small recursive-descent JSON parser, which understands just enough
+  of JSON to extract the items of a batch request, and to skip 
+  anything else. 
+
+  Copyright (c)1990-2020 Kevin Boone. Distributed under the terms of the
+  GNU Public Licence, v3.0
+
+  ==========================================================================*/
+#include <stdio.h> 
+#include <stdlib.h> 
+#include <string.h> 
+#include <klib/klib.h> 
+#include "batch_request.h" 
+
+#define KLOG_CLASS "solunar_ws.batch_request"
+
+// Deepest nesting of values that will be skipped
+#define MAX_DEPTH 16
+
+/*============================================================================
+  
+  BatchRequest 
+
+  ==========================================================================*/
+struct _BatchRequest
+  {
+  int count;
+  BatchItem items[BATCH_REQUEST_MAX_ITEMS];
+  };
+
+/*============================================================================
+  
+  Parser
+
+  ==========================================================================*/
+typedef struct _Parser
+  {
+  const char *p;
+  const char *end;
+  const char *error;
+  } Parser;
+
+/*============================================================================
+  
+  parser_skip_space
+
+  ==========================================================================*/
+static void parser_skip_space (Parser *ps)
+  {
+  while (ps->p < ps->end && (*ps->p == ' ' || *ps->p == '\t' 
+         || *ps->p == '\n' || *ps->p == '\r'))
+    ps->p++;
+  }
+
+/*============================================================================
+  
+  parser_expect
+
+  Skip white space, and then the specified character if it is next. 
+  Returns TRUE if it was.
+
+  ==========================================================================*/
+static BOOL parser_expect (Parser *ps, char c)
+  {
+  parser_skip_space (ps);
+  if (ps->p < ps->end && *ps->p == c)
+    {
+    ps->p++;
+    return TRUE;
+    }
+  return FALSE;
+  }
+
+/*============================================================================
+  
+  parser_hex4
+
+  Decode the four hex digits of a \u escape, which start at p. The 
+  upload buffer is not nul-terminated, so this must not look at or
+  beyond stop. Returns FALSE if there are fewer than four characters
+  before stop, or any of them is not a hex digit.
+
+  ==========================================================================*/
+static BOOL parser_hex4 (const char *p, const char *stop, unsigned int *c)
+  {
+  if (stop - p < 4) return FALSE;
+  unsigned int v = 0;
+  for (int i = 0; i < 4; i++)
+    {
+    char h = p[i];
+    v <<= 4;
+    if (h >= '0' && h <= '9') v |= h - '0';
+    else if (h >= 'a' && h <= 'f') v |= h - 'a' + 10;
+    else if (h >= 'A' && h <= 'F') v |= h - 'A' + 10;
+    else return FALSE;
+    }
+  *c = v;
+  return TRUE;
+  }
+
+/*============================================================================
+  
+  parser_string
+
+  Parse a string. If s is not NULL, it is set to a copy of the string,
+  with escapes decoded, which the caller must free. Returns FALSE on a 
+  syntax error.
+
+  ==========================================================================*/
+static BOOL parser_string (Parser *ps, char **s)
+  {
+  if (!parser_expect (ps, '"')) return FALSE;
+  // The decoded string can't be longer than the encoded one
+  const char *start = ps->p;
+  while (ps->p < ps->end && *ps->p != '"')
+    {
+    if (*ps->p == '\\') ps->p++;
+    ps->p++;
+    }
+  if (ps->p >= ps->end) return FALSE;
+  const char *stop = ps->p;
+  ps->p++;
+
+  if (s)
+    {
+    char *out = malloc (stop - start + 1);
+    char *o = out;
+    for (const char *q = start; q < stop; q++)
+      {
+      if (*q != '\\') 
+        {
+        *o++ = *q;
+        continue;
+        }
+      q++;
+      switch (*q)
+        {
+        case 'n': *o++ = '\n'; break;
+        case 't': *o++ = '\t'; break;
+        case 'r': *o++ = '\r'; break;
+        case 'b': *o++ = '\b'; break;
+        case 'f': *o++ = '\f'; break;
+        case 'u': 
+          {
+          // Only code points that are one UTF-8 byte are likely in a 
+          //  city name or date; anything else becomes '?'
+          unsigned int c;
+          if (!parser_hex4 (q + 1, stop, &c))
+            {
+            free (out);
+            return FALSE;
+            }
+          *o++ = (c < 0x80 && c > 0) ? c : '?';
+          q += 4;
+          }
+          break;
+        default: *o++ = *q;
+        }
+      }
+    *o = 0;
+    *s = out;
+    }
+  return TRUE;
+  }
+
+/*============================================================================
+  
+  parser_literal
+
+  Skip the specified word (true, false, or null), if it is next. 
+  Returns FALSE if it is not.
+
+  ==========================================================================*/
+static BOOL parser_literal (Parser *ps, const char *word)
+  {
+  size_t l = strlen (word);
+  if ((size_t)(ps->end - ps->p) < l || memcmp (ps->p, word, l) != 0) 
+    return FALSE;
+  ps->p += l;
+  return TRUE;
+  }
+
+/*============================================================================
+  
+  parser_digits
+
+  Skip one or more decimal digits. Returns FALSE if there are none.
+
+  ==========================================================================*/
+static BOOL parser_digits (Parser *ps)
+  {
+  const char *start = ps->p;
+  while (ps->p < ps->end && *ps->p >= '0' && *ps->p <= '9') 
+    ps->p++;
+  return ps->p > start;
+  }
+
+/*============================================================================
+  
+  parser_number
+
+  Skip a number: an optional minus sign, digits, optionally a fraction,
+  and optionally an exponent. Returns FALSE on a syntax error.
+
+  ==========================================================================*/
+static BOOL parser_number (Parser *ps)
+  {
+  if (ps->p < ps->end && *ps->p == '-') ps->p++;
+  if (!parser_digits (ps)) return FALSE;
+  if (ps->p < ps->end && *ps->p == '.')
+    {
+    ps->p++;
+    if (!parser_digits (ps)) return FALSE;
+    }
+  if (ps->p < ps->end && (*ps->p == 'e' || *ps->p == 'E'))
+    {
+    ps->p++;
+    if (ps->p < ps->end && (*ps->p == '+' || *ps->p == '-')) ps->p++;
+    if (!parser_digits (ps)) return FALSE;
+    }
+  return TRUE;
+  }
+
+/*============================================================================
+  
+  parser_skip_value
+
+  Skip over a value of any type. Returns FALSE on a syntax error.
+
+  ==========================================================================*/
+static BOOL parser_skip_value (Parser *ps, int depth)
+  {
+  if (depth > MAX_DEPTH) return FALSE;
+  parser_skip_space (ps);
+  if (ps->p >= ps->end) return FALSE;
+  char c = *ps->p;
+  if (c == '"') return parser_string (ps, NULL);
+  if (c == '{' || c == '[')
+    {
+    char close = (c == '{') ? '}' : ']';
+    ps->p++;
+    if (parser_expect (ps, close)) return TRUE;
+    do
+      {
+      if (c == '{')
+        {
+        if (!parser_string (ps, NULL)) return FALSE;
+        if (!parser_expect (ps, ':')) return FALSE;
+        }
+      if (!parser_skip_value (ps, depth + 1)) return FALSE;
+      } while (parser_expect (ps, ','));
+    return parser_expect (ps, close);
+    }
+  if (c == 't') return parser_literal (ps, "true");
+  if (c == 'f') return parser_literal (ps, "false");
+  if (c == 'n') return parser_literal (ps, "null");
+  return parser_number (ps);
+  }
+
+/*============================================================================
+  
+  parser_item
+
+  ==========================================================================*/
+static BOOL parser_item (Parser *ps, BatchItem *item)
+  {
+  if (!parser_expect (ps, '{')) return FALSE;
+  if (parser_expect (ps, '}')) return TRUE;
+  do
+    {
+    char *key;
+    if (!parser_string (ps, &key)) return FALSE;
+    BOOL ok = parser_expect (ps, ':');
+    if (ok)
+      {
+      char **value = NULL;
+      if (strcmp (key, "city") == 0) value = &item->city;
+      else if (strcmp (key, "date") == 0) value = &item->date;
+      if (value)
+        {
+        free (*value);
+        *value = NULL;
+        ok = parser_string (ps, value);
+        }
+      else
+        ok = parser_skip_value (ps, 1);
+      }
+    free (key);
+    if (!ok) return FALSE;
+    } while (parser_expect (ps, ','));
+  return parser_expect (ps, '}');
+  }
+
+/*============================================================================
+  
+  batch_request_parse
+
+  ==========================================================================*/
+BatchRequest *batch_request_parse (const char *body, size_t size,
+       const char **error)
+  {
+  KLOG_IN
+  BatchRequest *self = malloc (sizeof (BatchRequest));
+  self->count = 0;
+  Parser ps = { body, body + size, NULL };
+  BOOL ok = parser_expect (&ps, '[');
+  if (ok && !parser_expect (&ps, ']'))
+    {
+    do
+      {
+      if (self->count == BATCH_REQUEST_MAX_ITEMS)
+        {
+        ps.error = "Too many items in batch request";
+        ok = FALSE;
+        break;
+        }
+      BatchItem *item = &self->items[self->count++];
+      item->city = NULL;
+      item->date = NULL;
+      ok = parser_item (&ps, item);
+      } while (ok && parser_expect (&ps, ','));
+    if (ok) ok = parser_expect (&ps, ']');
+    }
+  if (ok)
+    {
+    parser_skip_space (&ps);
+    ok = (ps.p == ps.end);
+    }
+  if (!ok)
+    {
+    *error = ps.error ? ps.error : "Batch request is not a valid JSON array";
+    batch_request_destroy (self);
+    self = NULL;
+    }
+  KLOG_OUT
+  return self;
+  }
+
+/*============================================================================
+  
+  batch_request_destroy
+
+  ==========================================================================*/
+void batch_request_destroy (BatchRequest *self)
+  {
+  KLOG_IN
+  if (self)
+    {
+    for (int i = 0; i < self->count; i++)
+      {
+      free (self->items[i].city);
+      free (self->items[i].date);
+      }
+    free (self);
+    }
+  KLOG_OUT
+  }
+
+/*============================================================================
+  
+  batch_request_get_count
+
+  ==========================================================================*/
+int batch_request_get_count (const BatchRequest *self)
+  {
+  return self->count;
+  }
+
+/*============================================================================
+  
+  batch_request_get_item
+
+  ==========================================================================*/
+const BatchItem *batch_request_get_item (const BatchRequest *self, int i)
+  {
+  return &self->items[i];
+  }
+
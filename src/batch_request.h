@@ -0,0 +1,53 @@
+/*============================================================================
+  
+  solunar_ws 
+  
+  batch_request.h
+
+  Parser for the body of a /batch request, which is a JSON array of 
+  objects, each with "city" and "date" members, e.g.,
+
+  [{"city":"london","date":"2020-06-21"},{"city":"paris","date":"jun 21"}]
+
+  Other members are ignored. 
+
+  Copyright (c)1990-2020 Kevin Boone. Distributed under the terms of the
+  GNU Public Licence, v3.0
+
+  ==========================================================================*/
+
+#pragma once
+
+#include <stddef.h>
+#include <klib/klib.h>
+
+/** The largest number of items accepted in one request. */
+#define BATCH_REQUEST_MAX_ITEMS 1000
+
+typedef struct _BatchItem
+  {
+  char *city;  // NULL if the member was missing
+  char *date;  // Ditto
+  } BatchItem;
+
+struct _BatchRequest;
+typedef struct _BatchRequest BatchRequest;
+
+BEGIN_DECLS
+
+/** Parse a request body of the specified size. The body need not be 
+    nul-terminated. Returns NULL if the body can't be parsed, or has 
+    too many items, in which case *error is set to a message (which
+    is a constant, and must not be freed). */
+extern BatchRequest    *batch_request_parse (const char *body, size_t size,
+                          const char **error);
+
+extern void             batch_request_destroy (BatchRequest *self);
+
+extern int              batch_request_get_count (const BatchRequest *self);
+
+extern const BatchItem *batch_request_get_item (const BatchRequest *self, 
+                          int i);
+
+END_DECLS
+
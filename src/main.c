@@ -22,6 +22,28 @@
 
 #define KLOG_CLASS "solunar_ws.main"
 
+// The size of the pieces in which streamed responses are sent
+#define STREAM_BLOCK_SIZE 4096
+
+// The largest request body that will be accepted -- enough for a
+//  /batch request of the largest number of items
+#define MAX_UPLOAD_SIZE (256 * 1024)
+
+/*============================================================================
+
+  Upload
+
+  The body of a POST request, as it is collected from the successive
+  calls that microhttpd makes to handle_request
+
+============================================================================*/
+typedef struct _Upload
+  {
+  char *data;
+  size_t size;
+  BOOL too_large;
+  } Upload;
+
 /*============================================================================
 
   header_iterator
@@ -59,6 +81,30 @@ static int argument_iterator (void *data, enum MHD_ValueKind kind,
   return MHD_YES;
   }
 
+/*============================================================================
+
+  stream_reader
+
+  The microhttpd content reader for a ResponseStream
+
+============================================================================*/
+static ssize_t stream_reader (void *cls, uint64_t pos, char *buf, 
+        size_t max)
+  {
+  ssize_t n = response_stream_read ((ResponseStream *)cls, buf, max);
+  return n < 0 ? MHD_CONTENT_READER_END_OF_STREAM : n;
+  }
+
+/*============================================================================
+
+  stream_free
+
+============================================================================*/
+static void stream_free (void *cls)
+  {
+  response_stream_destroy ((ResponseStream *)cls);
+  }
+
 /*============================================================================
 
   handle_request 
@@ -77,6 +123,39 @@ int handle_request (void *_request_handler,
   int ret = MHD_YES;
   RequestHandler *request_handler = (RequestHandler*) _request_handler;
 
+  // For a POST, microhttpd calls this function once when the headers 
+  //  arrive, then once for each piece of the body, and then once more
+  //  with no data, when the body is complete. Only then is there 
+  //  anything to do
+  Upload *upload = *con_cls;
+  if (strcmp (method, MHD_HTTP_METHOD_POST) == 0)
+    {
+    if (!upload)
+      {
+      upload = malloc (sizeof (Upload));
+      memset (upload, 0, sizeof (Upload));
+      *con_cls = upload;
+      KLOG_OUT
+      return MHD_YES;
+      }
+    if (*upload_data_size > 0)
+      {
+      if (upload->size + *upload_data_size > MAX_UPLOAD_SIZE)
+        upload->too_large = TRUE;
+      if (!upload->too_large)
+        {
+        upload->data = realloc (upload->data, 
+          upload->size + *upload_data_size);
+        memcpy (upload->data + upload->size, upload_data, 
+          *upload_data_size);
+        upload->size += *upload_data_size;
+        }
+      *upload_data_size = 0;
+      KLOG_OUT
+      return MHD_YES;
+      }
+    }
+
   klog_debug (KLOG_CLASS, "request: %s", url);
 
   KProps *headers = kprops_new_empty();
@@ -90,28 +169,166 @@ int handle_request (void *_request_handler,
   struct MHD_Response *response;
 
   int code = 200;
-  char *buff;
-  request_handler_api (request_handler, url, arguments, &code, &buff);
-
-  response = MHD_create_response_from_buffer (strlen (buff),
-           (void*) buff, MHD_RESPMEM_MUST_FREE);
-  if (code == 200)
-    MHD_add_response_header (response, "Content-Type", 
-            "application/json; charset=utf8");
+  ResponseBody *body;
+  ResponseStream *stream = NULL;
+  char *server_timing = NULL;
+  if (upload && upload->too_large)
+    {
+    body = response_body_new_from_string (RESPONSE_BODY_TEXT, 
+      "Request body too large\n");
+    code = 413;
+    }
   else
-    MHD_add_response_header (response, "Content-Type", 
-            "text/plain; charset=utf8");
+    {
+    // The buffer takes over the upload data
+    KBuffer *buffer = NULL;
+    if (upload && upload->size > 0)
+      {
+      buffer = kbuffer_new_from_data_no_copy ((BYTE *)upload->data, 
+        upload->size);
+      upload->data = NULL;
+      }
+    request_handler_api (request_handler, method, url, arguments, buffer,
+      &code, &body, &stream, &server_timing);
+    if (buffer) kbuffer_destroy (buffer);
+    }
 
-  MHD_add_response_header (response, "Cache-Control", "no-cache");
-  ret = MHD_queue_response (connection, code, response);
-  MHD_destroy_response (response);
+  // A stream is sent with chunked encoding, a piece at a time, as 
+  //  microhttpd asks for it; microhttpd destroys it when it has 
+  //  finished with the response. Anything else is sent straight from 
+  //  the ResponseBody, which might be shared with the response cache. 
+  //  Our reference passes to microhttpd, which releases it through the 
+  //  free callback when it has finished with the response
+  const char *content_type;
+  if (stream)
+    {
+    content_type = response_stream_get_content_type (stream);
+    response = MHD_create_response_from_callback (MHD_SIZE_UNKNOWN, 
+           STREAM_BLOCK_SIZE, stream_reader, stream, stream_free);
+    }
+  else
+    {
+    content_type = response_body_get_content_type (body);
+    response = MHD_create_response_from_buffer_with_free_callback 
+           (response_body_get_size (body), 
+           (void *) response_body_get_data (body), response_body_unref_data);
+    }
+  if (response)
+    {
+    MHD_add_response_header (response, "Content-Type", content_type);
+    MHD_add_response_header (response, "Cache-Control", "no-cache");
+    if (server_timing)
+      MHD_add_response_header (response, "Server-Timing", server_timing);
+    ret = MHD_queue_response (connection, code, response);
+    MHD_destroy_response (response);
+    }
+  else
+    {
+    if (stream)
+      response_stream_destroy (stream);
+    else
+      response_body_unref (body);
+    ret = MHD_NO;
+    }
 
+  free (server_timing);
   kprops_destroy (headers);
   kprops_destroy (arguments);
   KLOG_OUT
   return ret;
   }
 
+/*============================================================================
+
+  request_completed
+
+  Called by microhttpd when it has finished with a request, whether or
+  not it completed normally, to free any upload
+
+============================================================================*/
+static void request_completed (void *cls, struct MHD_Connection *connection,
+      void **con_cls, enum MHD_RequestTerminationCode toe)
+  {
+  Upload *upload = *con_cls;
+  if (upload)
+    {
+    free (upload->data);
+    free (upload);
+    *con_cls = NULL;
+    }
+  }
+
+
+/*============================================================================
+
+  notify_connection 
+
+============================================================================*/
+static void notify_connection (void *_request_handler, 
+      struct MHD_Connection *connection, void **socket_context, 
+      enum MHD_ConnectionNotificationCode toe)
+  {
+  RequestHandler *request_handler = (RequestHandler*) _request_handler;
+  if (toe == MHD_CONNECTION_NOTIFY_STARTED)
+    request_handler_notify_connection (request_handler, TRUE);
+  else if (toe == MHD_CONNECTION_NOTIFY_CLOSED)
+    request_handler_notify_connection (request_handler, FALSE);
+  }
+
+/*============================================================================
+
+  start_daemon 
+
+  Start microhttpd in one of two serving modes. With threads == 0 we
+  get the original thread-per-connection model, which is fine for a
+  handful of clients, but pins a thread (and its stack) for every 
+  keep-alive connection. With threads > 0 we get a fixed pool of
+  worker threads, each running its own event loop -- epoll where 
+  microhttpd supports it, poll() otherwise. In pool mode the number
+  of threads, and hence the memory footprint, does not grow with the
+  number of connections.
+
+============================================================================*/
+static struct MHD_Daemon *start_daemon (int port, int threads, 
+      RequestHandler *request_handler)
+  {
+  KLOG_IN
+  struct MHD_Daemon *daemon;
+  if (threads > 0)
+    {
+    unsigned int flags = MHD_USE_INTERNAL_POLLING_THREAD;
+    const char *poller;
+    if (MHD_is_feature_supported (MHD_FEATURE_EPOLL) == MHD_YES)
+      {
+      flags |= MHD_USE_EPOLL;
+      poller = "epoll";
+      }
+    else
+      {
+      flags |= MHD_USE_POLL;
+      poller = "poll";
+      }
+    klog_info (KLOG_CLASS, "Serving with %d worker threads (%s)", 
+      threads, poller);
+    daemon = MHD_start_daemon (flags, port, NULL, NULL,
+	   handle_request, request_handler, 
+           MHD_OPTION_THREAD_POOL_SIZE, (unsigned int) threads,
+           MHD_OPTION_NOTIFY_CONNECTION, notify_connection, request_handler,
+           MHD_OPTION_NOTIFY_COMPLETED, request_completed, NULL,
+           MHD_OPTION_END);
+    }
+  else
+    {
+    klog_info (KLOG_CLASS, "Serving with one thread per connection");
+    daemon = MHD_start_daemon (MHD_USE_THREAD_PER_CONNECTION, port, 
+           NULL, NULL, handle_request, request_handler, 
+           MHD_OPTION_NOTIFY_CONNECTION, notify_connection, request_handler,
+           MHD_OPTION_NOTIFY_COMPLETED, request_completed, NULL,
+           MHD_OPTION_END);
+    }
+  KLOG_OUT
+  return daemon;
+  }
 
 /*============================================================================
   
@@ -137,11 +354,56 @@ int main (int argc, char **argv)
       program_context_get_integer (context, "log-level", KLOG_INFO);
     klog_set_log_level (log_level);
 
+    // Log from a background thread, so that request threads never 
+    //  wait for stderr -- useful when running at debug level
+    BOOL async_log = program_context_get_boolean (context, "async-log", 
+      FALSE);
+    if (async_log && !kasynclog_start (0))
+      klog_warn (KLOG_CLASS, "Can't start asynchronous logging");
+
     char *host = program_context_get (context, "host");
     if (!host) host = strdup ("0.0.0.0");
     int port = program_context_get_integer (context, "port", 
          8080);
 
+    int threads = program_context_get_integer (context, "threads", 0);
+
+    if (program_context_get_boolean (context, "preload-zones", FALSE))
+      solcity_preload_zones ();
+
+    char *moon_ephemeris = program_context_get (context, "moon-ephemeris");
+    if (moon_ephemeris)
+      {
+      if (strcmp (moon_ephemeris, "chebyshev") == 0)
+        moonephemera_set_backend (MOONEPHEMERA_CHEBYSHEV);
+      else if (strcmp (moon_ephemeris, "series") != 0)
+        klog_warn (KLOG_CLASS, "Unknown moon ephemeris '%s'; using series", 
+          moon_ephemeris);
+      free (moon_ephemeris);
+      }
+
+    char *moon_solver = program_context_get (context, "moon-solver");
+    if (moon_solver)
+      {
+      if (strcmp (moon_solver, "adaptive") == 0)
+        moontimes_set_solver (MOONTIMES_ADAPTIVE);
+      else if (strcmp (moon_solver, "sampled") != 0)
+        klog_warn (KLOG_CLASS, "Unknown moon solver '%s'; using sampled", 
+          moon_solver);
+      free (moon_solver);
+      }
+
+    char *sun_solver = program_context_get (context, "sun-solver");
+    if (sun_solver)
+      {
+      if (strcmp (sun_solver, "precise") == 0)
+        suntimes_set_solver (SUNTIMES_PRECISE);
+      else if (strcmp (sun_solver, "approximate") != 0)
+        klog_warn (KLOG_CLASS, 
+          "Unknown sun solver '%s'; using approximate", sun_solver);
+      free (sun_solver);
+      }
+
     klog_info (KLOG_CLASS, "host=%s, port=%d", host, port);
 
     RequestHandler *request_handler = request_handler_create (context);
@@ -157,9 +419,8 @@ int main (int argc, char **argv)
 
     klog_info (KLOG_CLASS, "HTTP server starting");
 
-    struct MHD_Daemon *daemon = MHD_start_daemon 
-	  (MHD_USE_THREAD_PER_CONNECTION, port, NULL, NULL,
-	   handle_request, request_handler, MHD_OPTION_END);
+    struct MHD_Daemon *daemon = start_daemon (port, threads, 
+           request_handler);
 
     if (daemon)
       {
@@ -189,6 +450,8 @@ int main (int argc, char **argv)
 
     request_handler_destroy (request_handler);
 
+    if (async_log) kasynclog_stop ();
+
     free (host);
     }
 
@@ -0,0 +1,413 @@
+/*============================================================================
+  
+  solunar_ws 
+  
+  metrics.c
+
+  All the counters are updated with relaxed atomic additions. A reader
+  might see, say, a histogram bucket that has been incremented before
+  the corresponding total, but every update is counted exactly once. 
+  Times are accumulated in nanoseconds, so that the sums are integers 
+  too.
+
+  Copyright (c)1990-2020 Kevin Boone. Distributed under the terms of the
+  GNU Public Licence, v3.0
+
+  ==========================================================================*/
+#include <stdio.h> 
+#include <stdlib.h> 
+#include <stdint.h> 
+#include <string.h> 
+#include <time.h> 
+#include <klib/klib.h> 
+#include "metrics.h" 
+
+#define KLOG_CLASS "solunar_ws.metrics"
+
+// Upper bounds of the latency buckets, in nanoseconds. The spacing is
+//  roughly 1-2.5-5 per decade, from 10us (a cache hit) to 1s 
+static const uint64_t latency_bounds[] = 
+  {
+  10000, 25000, 50000, 
+  100000, 250000, 500000, 
+  1000000, 2500000, 5000000, 
+  10000000, 25000000, 50000000, 
+  100000000, 250000000, 500000000, 
+  1000000000
+  };
+
+#define NUM_LATENCY_BOUNDS \
+  (int)(sizeof (latency_bounds) / sizeof (latency_bounds[0]))
+
+// Status classes: 2xx, 3xx, 4xx, 5xx
+#define NUM_CLASSES 4
+
+// Stage names, in the order of MetricsStage
+static const char *stage_names[METRICS_NUM_STAGES] = 
+  {
+  "parse_uri", "parse_date", "find_city", "cache", "sun", "moon", "json"
+  };
+
+/*============================================================================
+  
+  Histogram
+
+  counts[i] is the number of observations no larger than bounds[i], 
+  but larger than bounds[i-1]; the last element counts those larger 
+  than every bound. They are made cumulative, as Prometheus expects,
+  when they are written out.
+
+  ==========================================================================*/
+typedef struct _Histogram
+  {
+  uint64_t counts[NUM_LATENCY_BOUNDS + 1];
+  uint64_t count;
+  uint64_t sum;
+  } Histogram;
+
+/*============================================================================
+  
+  EndpointMetrics
+
+  ==========================================================================*/
+typedef struct _EndpointMetrics
+  {
+  uint64_t requests[NUM_CLASSES];
+  Histogram latency;
+  uint64_t bytes_sum;
+  uint64_t bytes_count;
+  Histogram stages[METRICS_NUM_STAGES];
+  } EndpointMetrics;
+
+/*============================================================================
+  
+  Metrics 
+
+  ==========================================================================*/
+struct _Metrics
+  {
+  int nendpoints;
+  const char *const *names;
+  EndpointMetrics *endpoints;
+  int64_t connections;
+  uint64_t connections_total;
+  };
+
+/*============================================================================
+  
+  metrics_now
+
+  ==========================================================================*/
+uint64_t metrics_now (void)
+  {
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+  }
+
+/*============================================================================
+  
+  metrics_new
+
+  ==========================================================================*/
+Metrics *metrics_new (int nendpoints, const char *const *names)
+  {
+  KLOG_IN
+  Metrics *self = malloc (sizeof (Metrics));
+  memset (self, 0, sizeof (Metrics));
+  self->nendpoints = nendpoints;
+  self->names = names;
+  self->endpoints = calloc (nendpoints, sizeof (EndpointMetrics));
+  KLOG_OUT
+  return self;
+  }
+
+/*============================================================================
+  
+  metrics_destroy
+
+  ==========================================================================*/
+void metrics_destroy (Metrics *self)
+  {
+  KLOG_IN
+  if (self)
+    {
+    free (self->endpoints);
+    free (self);
+    }
+  KLOG_OUT
+  }
+
+/*============================================================================
+  
+  metrics_add
+
+  ==========================================================================*/
+static inline void metrics_add (uint64_t *counter, uint64_t n)
+  {
+  __atomic_add_fetch (counter, n, __ATOMIC_RELAXED);
+  }
+
+/*============================================================================
+  
+  metrics_get
+
+  ==========================================================================*/
+static inline uint64_t metrics_get (const uint64_t *counter)
+  {
+  return __atomic_load_n (counter, __ATOMIC_RELAXED);
+  }
+
+/*============================================================================
+  
+  histogram_observe
+
+  ==========================================================================*/
+static void histogram_observe (Histogram *h, uint64_t ns)
+  {
+  int i = 0;
+  while (i < NUM_LATENCY_BOUNDS && ns > latency_bounds[i]) i++;
+  metrics_add (&h->counts[i], 1);
+  metrics_add (&h->count, 1);
+  metrics_add (&h->sum, ns);
+  }
+
+/*============================================================================
+  
+  histogram_write
+
+  Write the series for one histogram. labels is the text of any labels
+  other than "le", with a trailing comma, or an empty string.
+
+  ==========================================================================*/
+static void histogram_write (const Histogram *h, FILE *f, 
+       const char *name, const char *labels)
+  {
+  uint64_t cumulative = 0;
+  for (int i = 0; i < NUM_LATENCY_BOUNDS; i++)
+    {
+    cumulative += metrics_get (&h->counts[i]);
+    fprintf (f, "%s_bucket{%sle=\"%g\"} %llu\n", name, labels, 
+      latency_bounds[i] / 1e9, (unsigned long long)cumulative);
+    }
+  cumulative += metrics_get (&h->counts[NUM_LATENCY_BOUNDS]);
+  fprintf (f, "%s_bucket{%sle=\"+Inf\"} %llu\n", name, labels, 
+    (unsigned long long)cumulative);
+  // Strip the trailing comma for the series that have no "le"
+  int l = strlen (labels);
+  fprintf (f, "%s_sum{%.*s} %.9g\n", name, l > 0 ? l - 1 : 0, labels, 
+    metrics_get (&h->sum) / 1e9);
+  fprintf (f, "%s_count{%.*s} %llu\n", name, l > 0 ? l - 1 : 0, labels, 
+    (unsigned long long)metrics_get (&h->count));
+  }
+
+/*============================================================================
+  
+  metrics_record_request
+
+  ==========================================================================*/
+void metrics_record_request (Metrics *self, int endpoint, int code, 
+       uint64_t nanoseconds, size_t size)
+  {
+  KLOG_IN
+  if (endpoint >= 0 && endpoint < self->nendpoints)
+    {
+    EndpointMetrics *em = &self->endpoints[endpoint];
+    int cls = code / 100 - 2;
+    if (cls < 0) cls = 0;
+    if (cls >= NUM_CLASSES) cls = NUM_CLASSES - 1;
+    metrics_add (&em->requests[cls], 1);
+    histogram_observe (&em->latency, nanoseconds);
+    metrics_add (&em->bytes_sum, size);
+    metrics_add (&em->bytes_count, 1);
+    }
+  KLOG_OUT
+  }
+
+/*============================================================================
+  
+  metrics_record_timings
+
+  ==========================================================================*/
+void metrics_record_timings (Metrics *self, int endpoint, 
+       const MetricsTimings *timings)
+  {
+  KLOG_IN
+  if (endpoint >= 0 && endpoint < self->nendpoints)
+    {
+    EndpointMetrics *em = &self->endpoints[endpoint];
+    for (int i = 0; i < METRICS_NUM_STAGES; i++)
+      {
+      if (timings->done & (1 << i))
+        histogram_observe (&em->stages[i], timings->ns[i]);
+      }
+    }
+  KLOG_OUT
+  }
+
+/*============================================================================
+  
+  metrics_timings_init
+
+  ==========================================================================*/
+void metrics_timings_init (MetricsTimings *self)
+  {
+  memset (self, 0, sizeof (MetricsTimings));
+  self->mark = metrics_now ();
+  }
+
+/*============================================================================
+  
+  metrics_timings_add
+
+  ==========================================================================*/
+void metrics_timings_add (MetricsTimings *self, MetricsStage stage, 
+       uint64_t nanoseconds)
+  {
+  self->ns[stage] += nanoseconds;
+  self->done |= 1 << stage;
+  }
+
+/*============================================================================
+  
+  metrics_timings_mark
+
+  ==========================================================================*/
+void metrics_timings_mark (MetricsTimings *self, MetricsStage stage)
+  {
+  uint64_t now = metrics_now ();
+  metrics_timings_add (self, stage, now - self->mark);
+  self->mark = now;
+  }
+
+/*============================================================================
+  
+  metrics_timings_skip
+
+  ==========================================================================*/
+void metrics_timings_skip (MetricsTimings *self)
+  {
+  self->mark = metrics_now ();
+  }
+
+/*============================================================================
+  
+  metrics_timings_to_server_timing
+
+  ==========================================================================*/
+int metrics_timings_to_server_timing (const MetricsTimings *self, 
+       char *buff, size_t size)
+  {
+  KLOG_IN
+  int len = 0;
+  if (size > 0) buff[0] = 0;
+  for (int i = 0; i < METRICS_NUM_STAGES; i++)
+    {
+    if ((self->done & (1 << i)) && len < (int)size)
+      {
+      len += snprintf (buff + len, size - len, "%s%s;dur=%.3f", 
+        len ? ", " : "", stage_names[i], self->ns[i] / 1e6);
+      }
+    }
+  if (len >= (int)size) len = size > 0 ? (int)size - 1 : 0;
+  KLOG_OUT
+  return len;
+  }
+
+/*============================================================================
+  
+  metrics_connection_opened
+
+  ==========================================================================*/
+void metrics_connection_opened (Metrics *self)
+  {
+  __atomic_add_fetch (&self->connections, 1, __ATOMIC_RELAXED);
+  metrics_add (&self->connections_total, 1);
+  }
+
+/*============================================================================
+  
+  metrics_connection_closed
+
+  ==========================================================================*/
+void metrics_connection_closed (Metrics *self)
+  {
+  __atomic_sub_fetch (&self->connections, 1, __ATOMIC_RELAXED);
+  }
+
+/*============================================================================
+  
+  metrics_write
+
+  ==========================================================================*/
+void metrics_write (const Metrics *self, FILE *f)
+  {
+  KLOG_IN
+  static const char *classes[NUM_CLASSES] = {"2xx", "3xx", "4xx", "5xx"};
+
+  fprintf (f, "# HELP solunar_requests_total "
+    "Requests handled, by endpoint and status class.\n");
+  fprintf (f, "# TYPE solunar_requests_total counter\n");
+  for (int i = 0; i < self->nendpoints; i++)
+    {
+    for (int c = 0; c < NUM_CLASSES; c++)
+      {
+      fprintf (f, "solunar_requests_total{endpoint=\"%s\",code=\"%s\"} "
+        "%llu\n", self->names[i], classes[c], 
+        (unsigned long long)metrics_get (&self->endpoints[i].requests[c]));
+      }
+    }
+
+  fprintf (f, "# HELP solunar_request_duration_seconds "
+    "Time taken to handle requests, by endpoint.\n");
+  fprintf (f, "# TYPE solunar_request_duration_seconds histogram\n");
+  for (int i = 0; i < self->nendpoints; i++)
+    {
+    char labels[64];
+    snprintf (labels, sizeof (labels), "endpoint=\"%s\",", self->names[i]);
+    histogram_write (&self->endpoints[i].latency, f, 
+      "solunar_request_duration_seconds", labels);
+    }
+
+  fprintf (f, "# HELP solunar_stage_seconds "
+    "Time taken by each stage of handling requests, by endpoint.\n");
+  fprintf (f, "# TYPE solunar_stage_seconds histogram\n");
+  for (int i = 0; i < self->nendpoints; i++)
+    {
+    for (int j = 0; j < METRICS_NUM_STAGES; j++)
+      {
+      // Most endpoints have no stages, so only those that have been
+      //  seen are written
+      const Histogram *h = &self->endpoints[i].stages[j];
+      if (metrics_get (&h->count) == 0) continue;
+      char labels[64];
+      snprintf (labels, sizeof (labels), "endpoint=\"%s\",stage=\"%s\",", 
+        self->names[i], stage_names[j]);
+      histogram_write (h, f, "solunar_stage_seconds", labels);
+      }
+    }
+
+  fprintf (f, "# HELP solunar_response_size_bytes "
+    "Size of response bodies, by endpoint.\n");
+  fprintf (f, "# TYPE solunar_response_size_bytes summary\n");
+  for (int i = 0; i < self->nendpoints; i++)
+    {
+    const EndpointMetrics *em = &self->endpoints[i];
+    fprintf (f, "solunar_response_size_bytes_sum{endpoint=\"%s\"} %llu\n", 
+      self->names[i], (unsigned long long)metrics_get (&em->bytes_sum));
+    fprintf (f, "solunar_response_size_bytes_count{endpoint=\"%s\"} %llu\n", 
+      self->names[i], (unsigned long long)metrics_get (&em->bytes_count));
+    }
+
+  fprintf (f, "# HELP solunar_connections Open client connections.\n");
+  fprintf (f, "# TYPE solunar_connections gauge\n");
+  fprintf (f, "solunar_connections %lld\n", (long long)
+    __atomic_load_n (&self->connections, __ATOMIC_RELAXED));
+  fprintf (f, "# HELP solunar_connections_total "
+    "Client connections accepted.\n");
+  fprintf (f, "# TYPE solunar_connections_total counter\n");
+  fprintf (f, "solunar_connections_total %llu\n", 
+    (unsigned long long)metrics_get (&self->connections_total));
+  KLOG_OUT
+  }
+
@@ -0,0 +1,108 @@
+/*============================================================================
+  
+  solunar_ws 
+  
+  metrics.h
+
+  Counters and histograms describing the work the server does, which
+  any number of threads can update at once without locking, and which
+  can be written out in the Prometheus text exposition format. 
+
+  Requests are counted by endpoint -- the first element of the URI --
+  and by status class. For each endpoint there is a histogram of the 
+  time taken to handle the request, and a summary of the size of the 
+  response body. Handlers can also break down the time they take into
+  stages, each of which gets a histogram of its own.
+
+  Copyright (c)1990-2020 Kevin Boone. Distributed under the terms of the
+  GNU Public Licence, v3.0
+
+  ==========================================================================*/
+
+#pragma once
+
+#include <stdio.h>
+#include <stdint.h>
+#include <klib/klib.h>
+
+#define METRICS_CONTENT_TYPE "text/plain; version=0.0.4; charset=utf-8"
+
+/** The stages of handling a request that are timed separately. Not
+    every request passes through every stage. */
+typedef enum
+  {
+  METRICS_STAGE_PARSE_URI = 0,
+  METRICS_STAGE_PARSE_DATE,
+  METRICS_STAGE_FIND_CITY,
+  METRICS_STAGE_CACHE,
+  METRICS_STAGE_SUN,
+  METRICS_STAGE_MOON,
+  METRICS_STAGE_JSON,
+  METRICS_NUM_STAGES
+  } MetricsStage;
+
+/** The stage times for one request. This lives on the stack of the 
+    thread handling the request, so needs no synchronization. */
+typedef struct _MetricsTimings
+  {
+  uint64_t mark;      // End of the last stage timed
+  unsigned int done;  // Bit mask of the stages that have been timed
+  uint64_t ns[METRICS_NUM_STAGES];
+  } MetricsTimings;
+
+struct _Metrics;
+typedef struct _Metrics Metrics;
+
+BEGIN_DECLS
+
+/** Create a set of metrics for nendpoints endpoints, whose names are 
+    given, for use as label values. The names are not copied, and must
+    outlive the object. */
+extern Metrics *metrics_new (int nendpoints, const char *const *names);
+
+extern void     metrics_destroy (Metrics *self);
+
+/** Record the handling of a request. endpoint is an index into the
+    names passed to metrics_new(). */
+extern void     metrics_record_request (Metrics *self, int endpoint, 
+                  int code, uint64_t nanoseconds, size_t size);
+
+/** Record the stage times for a request to the specified endpoint. */
+extern void     metrics_record_timings (Metrics *self, int endpoint, 
+                  const MetricsTimings *timings);
+
+/** Record the opening or closing of a client connection. */
+extern void     metrics_connection_opened (Metrics *self);
+extern void     metrics_connection_closed (Metrics *self);
+
+/** Write all the metrics in Prometheus text format. */
+extern void     metrics_write (const Metrics *self, FILE *f);
+
+/** Get the time from a monotonic clock, in nanoseconds, for timing 
+    things to record here. */
+extern uint64_t metrics_now (void);
+
+/** Start timing a request. */
+extern void     metrics_timings_init (MetricsTimings *self);
+
+/** Add the time since the end of the last stage (or since 
+    metrics_timings_init()) to the specified stage. */
+extern void     metrics_timings_mark (MetricsTimings *self, 
+                  MetricsStage stage);
+
+/** Add a time measured elsewhere to the specified stage. This does not
+    mark the end of a stage; use metrics_timings_skip() for that. */
+extern void     metrics_timings_add (MetricsTimings *self, 
+                  MetricsStage stage, uint64_t nanoseconds);
+
+/** Mark the end of a stage, without adding its time to any stage. */
+extern void     metrics_timings_skip (MetricsTimings *self);
+
+/** Write the stage times in the format of an HTTP Server-Timing 
+    header, e.g., "find_city;dur=0.012, sun;dur=0.020" (in 
+    milliseconds). Returns the length written. */
+extern int      metrics_timings_to_server_timing 
+                  (const MetricsTimings *self, char *buff, size_t size);
+
+END_DECLS
+
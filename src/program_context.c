@@ -128,10 +128,18 @@ BOOL program_context_parse_command_line (ProgramContext *self,
   BOOL ret = TRUE;
   static struct option long_options[] =
     {
+      {"async-log", no_argument, NULL, 0},
+      {"batch-threads", required_argument, NULL, 0},
+      {"cache-size", required_argument, NULL, 0},
       {"help", no_argument, NULL, 0},
       {"host", required_argument, NULL, 'h'},
       {"log-level", required_argument, NULL, 'l'},
+      {"moon-ephemeris", required_argument, NULL, 0},
+      {"moon-solver", required_argument, NULL, 0},
       {"port", required_argument, NULL, 'p'},
+      {"preload-zones", no_argument, NULL, 0},
+      {"sun-solver", required_argument, NULL, 0},
+      {"threads", required_argument, NULL, 't'},
       {"version", no_argument, NULL, 'v'},
       {0, 0, 0, 0}
     };
@@ -140,7 +148,7 @@ BOOL program_context_parse_command_line (ProgramContext *self,
    while (ret)
      {
      int option_index = 0;
-     opt = getopt_long (argc, argv, "h:p:vl:",
+     opt = getopt_long (argc, argv, "h:p:t:vl:",
      long_options, &option_index);
 
      if (opt == -1) break;
@@ -152,12 +160,33 @@ BOOL program_context_parse_command_line (ProgramContext *self,
            program_context_put_boolean (self, "show-usage", TRUE);
          else if (strcmp (long_options[option_index].name, "version") == 0)
            program_context_put_boolean (self, "show-version", TRUE);
+         else if (strcmp (long_options[option_index].name, "async-log") == 0)
+           program_context_put_boolean (self, "async-log", TRUE); 
+         else if (strcmp (long_options[option_index].name, 
+               "batch-threads") == 0)
+           program_context_put_integer (self, "batch-threads", atoi (optarg)); 
+         else if (strcmp (long_options[option_index].name, "cache-size") == 0)
+           program_context_put_integer (self, "cache-size", atoi (optarg)); 
          else if (strcmp (long_options[option_index].name, "log-level") == 0)
            program_context_put_integer (self, "log-level", atoi (optarg)); 
+         else if (strcmp (long_options[option_index].name, 
+               "moon-ephemeris") == 0)
+           program_context_put (self, "moon-ephemeris", optarg); 
+         else if (strcmp (long_options[option_index].name, 
+               "moon-solver") == 0)
+           program_context_put (self, "moon-solver", optarg); 
          else if (strcmp (long_options[option_index].name, "port") == 0)
            program_context_put_integer (self, "port", atoi (optarg)); 
          else if (strcmp (long_options[option_index].name, "host") == 0)
            program_context_put (self, "host", optarg); 
+         else if (strcmp (long_options[option_index].name, "threads") == 0)
+           program_context_put_integer (self, "threads", atoi (optarg)); 
+         else if (strcmp (long_options[option_index].name, 
+               "preload-zones") == 0)
+           program_context_put_boolean (self, "preload-zones", TRUE); 
+         else if (strcmp (long_options[option_index].name, 
+               "sun-solver") == 0)
+           program_context_put (self, "sun-solver", optarg); 
          else
            exit (-1);
          break;
@@ -170,6 +199,8 @@ BOOL program_context_parse_command_line (ProgramContext *self,
            atoi (optarg)); break;
        case 'l': program_context_put_integer (self, "log-level", 
            atoi (optarg)); break;
+       case 't': program_context_put_integer (self, "threads", 
+           atoi (optarg)); break;
        default:
          ret = FALSE; 
        }
@@ -328,10 +359,23 @@ void program_context_show_usage (FILE *fout, const char *argv0)
   {
   KLOG_IN
   fprintf (fout, "Usage: %s [options]\n", argv0);
+  fprintf (fout, "     --async-log          write log messages from a background thread\n");
+  fprintf (fout, "     --batch-threads=[number] threads for /batch "
+                   "(default: CPUs)\n");
+  fprintf (fout, "     --cache-size=[number] /day responses to cache (default 4096)\n");
   fprintf (fout, "     --help               show this message\n");
   fprintf (fout, "  -h,--host=[hostname]    bind host or IP\n");
   fprintf (fout, "  -l,--log-level=[0..5]   log level (default 2)\n");
+  fprintf (fout, "     --moon-ephemeris=[series|chebyshev]\n");
+  fprintf (fout, "                          moon position method (default series)\n");
+  fprintf (fout, "     --moon-solver=[sampled|adaptive]\n");
+  fprintf (fout, "                          moonrise/set method (default sampled)\n");
   fprintf (fout, "  -p,--port=[number]      server IP port\n");
+  fprintf (fout, "     --preload-zones      load all city timezones at start\n");
+  fprintf (fout, "     --sun-solver=[approximate|precise]\n");
+  fprintf (fout, "                          sunrise/set method (default approximate)\n");
+  fprintf (fout, "  -t,--threads=[number]   worker pool size (default 0, "
+                   "thread per connection)\n");
   fprintf (fout, "  -v,--version            show version\n");
   KLOG_OUT
   }
@@ -19,43 +19,85 @@
 #include <time.h>
 #include <fcntl.h>
 #include <ctype.h>
+#include <math.h>
 #include <microhttpd.h>
 #include <klib/klib.h>
 #include <libsolunar/libsolunar.h>
 #include "request_handler.h" 
+#include "response_body.h" 
+#include "response_stream.h" 
+#include "response_cache.h" 
+#include "metrics.h" 
+#include "work_pool.h" 
+#include "batch_request.h" 
 
 #define KLOG_CLASS "solunar_ws.request_handler"
 
+// The longest /range request that will be accepted -- about ten years
+#define MAX_RANGE_DAYS 3660
+
+// The years that /year will work out
+#define MIN_YEAR 1900
+#define MAX_YEAR 2200
+
+#define SECS_PER_DAY 86400
+
 struct _RequestHandler
   {
   BOOL shutdown_requested;
-  int requests;
-  int ok_requests;
   const ProgramContext *context;
+  Metrics *metrics;
+  const char **endpoint_names;
+  int nendpoints;
+  WorkPool *work_pool;
+  ResponseCache *day_cache;
+  ResponseCache *year_cache;
+  ResponseBody *health_body;
   }; 
 
 typedef void (*APIHandlerFn) (const RequestHandler *self, 
-      const KList *list, char **response, int *code);
+      const KList *list, const KBuffer *upload, ResponseBody **response, 
+      ResponseStream **stream, int *code, MetricsTimings *timings);
 
 typedef struct _APIHandler 
   {
   const char *name;
+  BOOL post; // TRUE if the handler takes POST requests, not GET
   APIHandlerFn fn;
   } APIHandler;
 
+void request_handler_batch (const RequestHandler *self, const KList *list, 
+      const KBuffer *upload, ResponseBody **response, 
+      ResponseStream **stream, int *code, MetricsTimings *timings);
+void request_handler_coords (const RequestHandler *self, const KList *list, 
+      const KBuffer *upload, ResponseBody **response, 
+      ResponseStream **stream, int *code, MetricsTimings *timings);
 void request_handler_day (const RequestHandler *self, const KList *list, 
-      char **response, int *code);
+      const KBuffer *upload, ResponseBody **response, 
+      ResponseStream **stream, int *code, MetricsTimings *timings);
 void request_handler_health (const RequestHandler *self, const KList *list, 
-      char **response, int *code);
+      const KBuffer *upload, ResponseBody **response, 
+      ResponseStream **stream, int *code, MetricsTimings *timings);
 void request_handler_metrics (const RequestHandler *self, const KList *list, 
-      char **response, int *code);
+      const KBuffer *upload, ResponseBody **response, 
+      ResponseStream **stream, int *code, MetricsTimings *timings);
+void request_handler_range (const RequestHandler *self, const KList *list, 
+      const KBuffer *upload, ResponseBody **response, 
+      ResponseStream **stream, int *code, MetricsTimings *timings);
+void request_handler_year (const RequestHandler *self, const KList *list, 
+      const KBuffer *upload, ResponseBody **response, 
+      ResponseStream **stream, int *code, MetricsTimings *timings);
 
 APIHandler handlers[] = 
   {
-  {"day", request_handler_day},
-  {"health", request_handler_health},
-  {"metrics", request_handler_metrics},
-  {NULL, NULL}
+  {"batch", TRUE, request_handler_batch},
+  {"coords", FALSE, request_handler_coords},
+  {"day", FALSE, request_handler_day},
+  {"health", FALSE, request_handler_health},
+  {"metrics", FALSE, request_handler_metrics},
+  {"range", FALSE, request_handler_range},
+  {"year", FALSE, request_handler_year},
+  {NULL, FALSE, NULL}
   };
 
 /*============================================================================
@@ -69,8 +111,28 @@ RequestHandler *request_handler_create (const ProgramContext *context)
   RequestHandler *self = malloc (sizeof (RequestHandler)); 
   self->shutdown_requested = FALSE;
   self->context = context;
-  self->requests = 0;
-  self->ok_requests = 0;
+
+  // One set of metrics for each API handler, and one for requests
+  //  that don't match any handler
+  int nhandlers = 0;
+  while (handlers[nhandlers].name) nhandlers++;
+  self->nendpoints = nhandlers + 1;
+  self->endpoint_names = malloc (self->nendpoints * sizeof (char *));
+  for (int i = 0; i < nhandlers; i++)
+    self->endpoint_names[i] = handlers[i].name;
+  self->endpoint_names[nhandlers] = "other";
+  self->metrics = metrics_new (self->nendpoints, self->endpoint_names);
+
+  int cache_size = program_context_get_integer (context, "cache-size", 
+    REQUEST_HANDLER_DEFAULT_CACHE_SIZE);
+  klog_info (KLOG_CLASS, "Response cache size=%d", cache_size);
+  self->day_cache = response_cache_new (cache_size);
+  self->year_cache = response_cache_new (REQUEST_HANDLER_YEAR_CACHE_SIZE);
+  int batch_threads = program_context_get_integer (context, "batch-threads", 
+    sysconf (_SC_NPROCESSORS_ONLN));
+  self->work_pool = work_pool_new (batch_threads);
+  self->health_body = response_body_new_from_string (RESPONSE_BODY_JSON, 
+    "{\"health\": \"OK\"}\n");
   KLOG_OUT 
   return self;
   }
@@ -85,12 +147,120 @@ void request_handler_destroy (RequestHandler *self)
   KLOG_IN
   if (self)
     {
+    work_pool_destroy (self->work_pool);
+    response_cache_destroy (self->day_cache);
+    response_cache_destroy (self->year_cache);
+    response_body_unref (self->health_body);
+    metrics_destroy (self->metrics);
+    free (self->endpoint_names);
     free (self);
     }
   KLOG_OUT 
   }
 
 
+/*============================================================================
+
+  request_handler_day_summary
+
+  Get the JSON day summary for a location, from the cache if it is 
+  there, or by working it out and storing it in the cache if not.
+
+============================================================================*/
+static ResponseBody *request_handler_day_summary 
+       (const RequestHandler *self, const char *key, time_t t_date, 
+       double latitude, double longitude, const char *city, 
+       const KTimeZone *zone, MetricsTimings *timings)
+  {
+  KLOG_IN
+  ResponseBody *ret = response_cache_get (self->day_cache, key);
+  metrics_timings_mark (timings, METRICS_STAGE_CACHE);
+  if (!ret)
+    {
+    SolunarDaySummary *sds = solunar_day_summary_create_in_zone 
+      (t_date, latitude, longitude, city, zone);
+    uint64_t sun_ns, moon_ns;
+    solunar_day_summary_get_timings (sds, &sun_ns, &moon_ns);
+    metrics_timings_add (timings, METRICS_STAGE_SUN, sun_ns);
+    metrics_timings_add (timings, METRICS_STAGE_MOON, moon_ns);
+    metrics_timings_skip (timings);
+
+    // A day summary is well under 2kB, so it is written on the
+    //  stack, and copied just once, into the response body
+    char buff[2048];
+    KJsonWriter *w = kjsonwriter_new_with_buffer (buff, sizeof (buff));
+    solunar_day_summary_write_json (sds, w, KJSONWRITER_NEWLINES);
+    ret = response_body_new (RESPONSE_BODY_JSON, kjsonwriter_get_data (w),
+      kjsonwriter_get_length (w));
+    kjsonwriter_destroy (w);
+
+    solunar_day_summary_destroy (sds);
+    metrics_timings_mark (timings, METRICS_STAGE_JSON);
+    response_cache_put (self->day_cache, key, ret);
+    metrics_timings_mark (timings, METRICS_STAGE_CACHE);
+    }
+  KLOG_OUT
+  return ret;
+  }
+
+/*============================================================================
+
+  request_handler_day_for
+
+  Get the response for one city and date, as for the /day API
+
+============================================================================*/
+static ResponseBody *request_handler_day_for (const RequestHandler *self, 
+       const char *city, const char *date, int *code, 
+       MetricsTimings *timings)
+  {
+  KLOG_IN
+  ResponseBody *response;
+  time_t t_date = datetimeconv_parse_date (date, 2, 0, NULL);
+  metrics_timings_mark (timings, METRICS_STAGE_PARSE_DATE);
+  if (t_date)
+    {
+    const SolCity *c;
+    int cities = solcity_find_unique ((UTF8 *)city, &c);
+    metrics_timings_mark (timings, METRICS_STAGE_FIND_CITY);
+    if (cities > 0)
+      {
+      if (cities == 1)
+        {
+        const char *full_city = solcity_get_name (c);
+        // The response depends only on the city and the date, so
+        //  it can be cached indefinitely
+        char key[128];
+        snprintf (key, sizeof (key), "%s/%ld", full_city, (long)t_date);
+        response = request_handler_day_summary (self, key, t_date,
+          solcity_get_latitude (c), solcity_get_longitude (c), 
+          full_city, solcity_get_zone (c), timings);
+        *code = 200;
+        }
+      else
+        {
+        response = response_body_new_printf (RESPONSE_BODY_TEXT, 
+          "Ambiguous city: %d matches\n", cities);
+        *code = 400;
+        }
+      }
+    else
+      {
+      response = response_body_new_from_string (RESPONSE_BODY_TEXT, 
+        "Could not find city\n");
+      *code = 400;
+      }
+    }
+  else
+    {
+    response = response_body_new_from_string (RESPONSE_BODY_TEXT, 
+      "Could not parse date\n");
+    *code = 400;
+    }
+  KLOG_OUT
+  return response;
+  }
+
 /*============================================================================
 
   request_handler_day
@@ -99,7 +269,8 @@ void request_handler_destroy (RequestHandler *self)
 
 ============================================================================*/
 void request_handler_day (const RequestHandler *self, const KList *args, 
-       char **response, int *code)
+       const KBuffer *upload, ResponseBody **response, 
+       ResponseStream **stream, int *code, MetricsTimings *timings)
   {
   KLOG_IN
   int argc = klist_length ((KList *)args);
@@ -111,53 +282,500 @@ void request_handler_day (const RequestHandler *self, const KList *args,
     klog_debug (KLOG_CLASS, "/day invoked with city=%s and date=%s", 
        city, date); 
 
-    time_t t_date = datetimeconv_parse_date (date, 2, 0, NULL);
-    if (t_date)
+    *response = request_handler_day_for (self, city, date, code, timings);
+    }
+  else
+    {
+    *response = response_body_new_from_string (RESPONSE_BODY_TEXT, 
+      "/day API takes two arguments -- city and date\n");
+    *code = 400;
+    }
+  KLOG_OUT
+  }
+
+/*============================================================================
+
+  DayRange
+
+  The state of a /range response, which is produced a day at a time,
+  as the client reads it. Only one day's summary is held at once, in 
+  a writer whose buffer is reused from one day to the next, so the
+  memory used does not depend on the length of the range. The city is
+  looked up, and its zone found, only once; the moon positions for 
+  each UTC day are shared, through the moon position cache, by the
+  two local days that overlap it.
+
+============================================================================*/
+typedef struct _DayRange
+  {
+  const RequestHandler *self;
+  double latitude;
+  double longitude;
+  const char *city;
+  const KTimeZone *zone;
+  time_t t_date; // The next day to work out
+  int days; // The number of days still to work out
+  KJsonWriter *w; // The day being sent
+  size_t pos; // How much of it has been sent
+  int endpoint;
+  uint64_t start;
+  size_t size; // The number of bytes sent so far
+  } DayRange;
+
+/*============================================================================
+
+  request_handler_year
+
+  Generate a request for the /year/city/year API. The response is the 
+  list of festivals, as produced by solunar_year_summary_to_json().
+  The festivals depend only on the year, the zone -- Easter and the 
+  days that follow from it are at 02:00 local time -- and the 
+  hemisphere, which decides which solstice is the summer one. So one
+  response is cached for each year, zone, and hemisphere, and shared 
+  by all the cities that have them in common.
+
+============================================================================*/
+void request_handler_year (const RequestHandler *self, const KList *args, 
+       const KBuffer *upload, ResponseBody **response, 
+       ResponseStream **stream, int *code, MetricsTimings *timings)
+  {
+  KLOG_IN
+  int argc = klist_length ((KList *)args);
+  if (argc == 3)
+    {
+    const char *city = klist_get ((KList *)args, 1); 
+    const char *s_year = klist_get ((KList *)args, 2); 
+
+    klog_debug (KLOG_CLASS, "/year invoked with city=%s and year=%s", 
+       city, s_year); 
+
+    char *end;
+    long year = strtol (s_year, &end, 10);
+    metrics_timings_mark (timings, METRICS_STAGE_PARSE_DATE);
+    if (*s_year && *end == 0 && year >= MIN_YEAR && year <= MAX_YEAR)
+      {
+      const SolCity *c;
+      int cities = solcity_find_unique ((UTF8 *)city, &c);
+      metrics_timings_mark (timings, METRICS_STAGE_FIND_CITY);
+      if (cities == 1)
+        {
+        const KTimeZone *zone = solcity_get_zone (c);
+        double latitude = solcity_get_latitude (c);
+        BOOL southern = latitude <= 0;
+        char key[128];
+        snprintf (key, sizeof (key), "%s/%ld/%c", 
+          zone ? ktimezone_get_name (zone) : "", year, southern ? 'S' : 'N');
+        *response = response_cache_get (self->year_cache, key);
+        metrics_timings_mark (timings, METRICS_STAGE_CACHE);
+        if (!*response)
+          {
+          // Any latitude in the same hemisphere gives the same result
+          SolunarYearSummary *sys = solunar_year_summary_create_in_zone 
+            (year, southern ? -1 : 1, zone);
+          KJsonWriter *w = kjsonwriter_new ();
+          solunar_year_summary_write_json (sys, w);
+          *response = response_body_new (RESPONSE_BODY_JSON, 
+            kjsonwriter_get_data (w), kjsonwriter_get_length (w));
+          kjsonwriter_destroy (w);
+          solunar_year_summary_destroy (sys);
+          metrics_timings_mark (timings, METRICS_STAGE_JSON);
+          response_cache_put (self->year_cache, key, *response);
+          metrics_timings_mark (timings, METRICS_STAGE_CACHE);
+          }
+        *code = 200;
+        }
+      else if (cities > 1)
+        {
+        *response = response_body_new_printf (RESPONSE_BODY_TEXT, 
+          "Ambiguous city: %d matches\n", cities);
+        *code = 400;
+        }
+      else
+        {
+        *response = response_body_new_from_string (RESPONSE_BODY_TEXT, 
+          "Could not find city\n");
+        *code = 400;
+        }
+      }
+    else
+      {
+      *response = response_body_new_printf (RESPONSE_BODY_TEXT, 
+        "Year must be from %d to %d\n", MIN_YEAR, MAX_YEAR);
+      *code = 400;
+      }
+    }
+  else
+    {
+    *response = response_body_new_from_string (RESPONSE_BODY_TEXT, 
+      "/year API takes two arguments -- city and year\n");
+    *code = 400;
+    }
+  KLOG_OUT
+  }
+
+/*============================================================================
+
+  request_handler_find_endpoint
+
+  Get the index in the metrics of the named API handler
+
+============================================================================*/
+static int request_handler_find_endpoint (const char *name)
+  {
+  int i = 0;
+  while (handlers[i].name && strcmp (handlers[i].name, name) != 0) i++;
+  return i;
+  }
+
+/*============================================================================
+
+  request_handler_range_read
+
+  Fill the client's buffer from the current day's summary, working out 
+  the next day when that has all been sent.
+
+============================================================================*/
+static ssize_t request_handler_range_read (void *user_data, char *buff, 
+       size_t max)
+  {
+  KLOG_IN
+  DayRange *range = user_data;
+  if (range->pos == kjsonwriter_get_length (range->w))
+    {
+    if (range->days == 0)
+      {
+      KLOG_OUT
+      return -1;
+      }
+    SolunarDaySummary *sds = solunar_day_summary_create_in_zone 
+      (range->t_date, range->latitude, range->longitude, range->city, 
+      range->zone);
+    kjsonwriter_reset (range->w);
+    solunar_day_summary_write_json (sds, range->w, 0);
+    kjsonwriter_raw (range->w, "\n", 1);
+    solunar_day_summary_destroy (sds);
+    range->pos = 0;
+    range->days--;
+    // Dates are parsed as 02:00 local time, and so are the following 
+    //  days, so that each day is worked out exactly as /day would do it
+    range->t_date = datetimeconv_make_time_on_day 
+      (range->t_date + SECS_PER_DAY, 2, 0, 0, NULL);
+    }
+  size_t n = kjsonwriter_get_length (range->w) - range->pos;
+  if (n > max) n = max;
+  memcpy (buff, kjsonwriter_get_data (range->w) + range->pos, n);
+  range->pos += n;
+  range->size += n;
+  KLOG_OUT
+  return n;
+  }
+
+/*============================================================================
+
+  request_handler_range_free
+
+  Called when the /range response is finished with. Only now is the
+  request complete, so this is where it is counted in the metrics.
+
+============================================================================*/
+static void request_handler_range_free (void *user_data)
+  {
+  KLOG_IN
+  DayRange *range = user_data;
+  metrics_record_request (range->self->metrics, range->endpoint, 200, 
+    metrics_now () - range->start, range->size);
+  kjsonwriter_destroy (range->w);
+  free (range);
+  KLOG_OUT
+  }
+
+/*============================================================================
+
+  request_handler_range
+
+  Generate a request for the /range/city/start/end API. The response
+  is newline-delimited JSON -- one day summary, on a single line, for 
+  each day from start to end inclusive. The summaries are not taken 
+  from, or stored in, the response cache: they are in a different 
+  format from the /day summaries, and a long range would push 
+  everything else out of the cache.
+
+============================================================================*/
+void request_handler_range (const RequestHandler *self, const KList *args, 
+       const KBuffer *upload, ResponseBody **response, 
+       ResponseStream **stream, int *code, MetricsTimings *timings)
+  {
+  KLOG_IN
+  int argc = klist_length ((KList *)args);
+  if (argc == 4)
+    {
+    const char *city = klist_get ((KList *)args, 1); 
+    const char *s_start = klist_get ((KList *)args, 2); 
+    const char *s_end = klist_get ((KList *)args, 3); 
+
+    klog_debug (KLOG_CLASS, "/range invoked with city=%s, start=%s, end=%s", 
+       city, s_start, s_end); 
+
+    time_t t_start = datetimeconv_parse_date (s_start, 2, 0, NULL);
+    time_t t_end = datetimeconv_parse_date (s_end, 2, 0, NULL);
+    metrics_timings_mark (timings, METRICS_STAGE_PARSE_DATE);
+    // Days are not all the same length, where daylight saving starts
+    //  or ends, but they are all within an hour of it
+    long days = 0;
+    if (t_start && t_end && t_end >= t_start)
+      days = (t_end - t_start + SECS_PER_DAY / 2) / SECS_PER_DAY + 1;
+    if (days > 0 && days <= MAX_RANGE_DAYS)
       {
-      KList *city_list = solcity_find_matching ((UTF8 *)city);
-      if (city_list)
+      const SolCity *c;
+      int cities = solcity_find_unique ((UTF8 *)city, &c);
+      metrics_timings_mark (timings, METRICS_STAGE_FIND_CITY);
+      if (cities == 1)
         {
-        int cities = klist_length (city_list);
-        if (cities == 1)
-	  {
-	  const SolCity *c = klist_get (city_list, 0);
-	  const char *tz_city = solcity_get_tz_name (c);
-	  const char *full_city = solcity_get_name (c);
-	  double latitude = solcity_get_latitude (c);
-	  double longitude = solcity_get_longitude (c);
-          SolunarDaySummary *sds = solunar_day_summary_create 
-            (t_date, latitude, longitude, full_city, tz_city);
-
-          KString *json = solunar_day_summary_to_json (sds);
-          *response = (char *)kstring_to_utf8 (json);
-          kstring_destroy (json);
-
-          solunar_day_summary_destroy (sds);
-          *code = 200;
-	  }
-	else
-	  {
-	  asprintf (response, "Ambiguous city: %d matches\n", cities);
-          *code = 400;
-	  }
-        klist_destroy (city_list);
+        DayRange *range = malloc (sizeof (DayRange));
+        range->self = self;
+        range->latitude = solcity_get_latitude (c);
+        range->longitude = solcity_get_longitude (c);
+        range->city = solcity_get_name (c);
+        range->zone = solcity_get_zone (c);
+        range->t_date = t_start;
+        range->days = days;
+        range->w = kjsonwriter_new ();
+        range->pos = 0;
+        range->endpoint = request_handler_find_endpoint ("range");
+        range->start = metrics_now ();
+        range->size = 0;
+        *stream = response_stream_new (RESPONSE_BODY_NDJSON, 
+          request_handler_range_read, request_handler_range_free, range);
+        *code = 200;
+        }
+      else if (cities > 1)
+        {
+        *response = response_body_new_printf (RESPONSE_BODY_TEXT, 
+          "Ambiguous city: %d matches\n", cities);
+        *code = 400;
         }
       else
         {
-        asprintf (response, "Could not find city\n");
+        *response = response_body_new_from_string (RESPONSE_BODY_TEXT, 
+          "Could not find city\n");
         *code = 400;
         }
+      }
+    else if (t_start && t_end)
+      {
+      *response = response_body_new_printf (RESPONSE_BODY_TEXT, 
+        "Range must be from 1 to %d days\n", MAX_RANGE_DAYS);
+      *code = 400;
+      }
+    else
+      {
+      *response = response_body_new_from_string (RESPONSE_BODY_TEXT, 
+        "Could not parse date\n");
+      *code = 400;
+      }
+    }
+  else
+    {
+    *response = response_body_new_from_string (RESPONSE_BODY_TEXT, 
+      "/range API takes three arguments -- city, start date, and end date\n");
+    *code = 400;
+    }
+  KLOG_OUT
+  }
+
+/*============================================================================
+
+  BatchJob
+
+  The state shared by the threads working on one /batch request
+
+============================================================================*/
+typedef struct _BatchJob
+  {
+  const RequestHandler *self;
+  const BatchRequest *request;
+  ResponseBody **responses;
+  int *codes;
+  } BatchJob;
+
+/*============================================================================
+
+  request_handler_batch_item
+
+  Work out item i of a /batch request. This is called in one of the 
+  work pool threads, or in the thread that is handling the request.
+
+============================================================================*/
+static void request_handler_batch_item (int i, void *user_data)
+  {
+  BatchJob *job = user_data;
+  const BatchItem *item = batch_request_get_item (job->request, i);
+  // The stages of each item aren't reported, but the functions that 
+  //  work out the response expect to time them
+  MetricsTimings timings;
+  metrics_timings_init (&timings);
+  if (item->city && item->date)
+    job->responses[i] = request_handler_day_for (job->self, item->city, 
+      item->date, &job->codes[i], &timings);
+  else
+    {
+    job->responses[i] = response_body_new_from_string (RESPONSE_BODY_TEXT, 
+      "Batch item needs a city and a date\n");
+    job->codes[i] = 400;
+    }
+  }
+
+/*============================================================================
 
+  request_handler_batch
+
+  Handle POST /batch, whose body is a JSON array of {city, date} items.
+  The response is a JSON array of the same length, of day summaries in
+  the same format as /day, or {"error":"..."} objects for items that 
+  could not be worked out. The items are spread across the work pool; 
+  they share the response cache, the moon position cache, and the 
+  timezones with /day, so items for the same date, or that have 
+  been asked for before, cost little.
+
+============================================================================*/
+void request_handler_batch (const RequestHandler *self, const KList *args, 
+       const KBuffer *upload, ResponseBody **response, 
+       ResponseStream **stream, int *code, MetricsTimings *timings)
+  {
+  KLOG_IN
+  const char *error = "Batch request has no body";
+  BatchRequest *request = NULL;
+  if (upload)
+    request = batch_request_parse ((const char *)kbuffer_get_data (upload), 
+      kbuffer_get_size (upload), &error);
+  metrics_timings_mark (timings, METRICS_STAGE_PARSE_URI);
+  if (request)
+    {
+    int n = batch_request_get_count (request);
+    klog_debug (KLOG_CLASS, "/batch invoked with %d items", n); 
+    BatchJob job;
+    job.self = self;
+    job.request = request;
+    job.responses = malloc ((n > 0 ? n : 1) * sizeof (ResponseBody *));
+    job.codes = malloc ((n > 0 ? n : 1) * sizeof (int));
+    work_pool_run (self->work_pool, n, request_handler_batch_item, &job);
+
+    KJsonWriter *w = kjsonwriter_new ();
+    kjsonwriter_begin_array (w, KJSONWRITER_NEWLINES);
+    for (int i = 0; i < n; i++)
+      {
+      ResponseBody *r = job.responses[i];
+      if (job.codes[i] == 200)
+        kjsonwriter_json (w, response_body_get_data (r), 
+          response_body_get_size (r));
+      else
+        {
+        // Error responses are text, ending in a newline
+        char msg[128];
+        snprintf (msg, sizeof (msg), "%.*s", 
+          (int)response_body_get_size (r), response_body_get_data (r));
+        msg[strcspn (msg, "\n")] = 0;
+        kjsonwriter_begin_object (w, 0);
+        kjsonwriter_key (w, "error");
+        kjsonwriter_string (w, msg);
+        kjsonwriter_end_object (w);
+        }
+      response_body_unref (r);
+      }
+    kjsonwriter_end_array (w);
+    kjsonwriter_newline (w);
+    metrics_timings_mark (timings, METRICS_STAGE_JSON);
+
+    *response = response_body_new (RESPONSE_BODY_JSON, 
+      kjsonwriter_get_data (w), kjsonwriter_get_length (w));
+    *code = 200;
+    kjsonwriter_destroy (w);
+    free (job.responses);
+    free (job.codes);
+    batch_request_destroy (request);
+    }
+  else
+    {
+    *response = response_body_new_printf (RESPONSE_BODY_TEXT, "%s\n", 
+      error);
+    *code = 400;
+    }
+  KLOG_OUT
+  }
+
+/*============================================================================
+
+  request_handler_coords
+
+  Generate a request for the /coords/latitude/longitude/date API. The
+  timezone is that of the nearest city, and the "city" in the output
+  is the name of that city; but the calculations are done for the 
+  specified location, rounded to four decimal places (about ten 
+  metres), and it is the rounded location that is reported.
+
+============================================================================*/
+void request_handler_coords (const RequestHandler *self, const KList *args, 
+       const KBuffer *upload, ResponseBody **response, 
+       ResponseStream **stream, int *code, MetricsTimings *timings)
+  {
+  KLOG_IN
+  int argc = klist_length ((KList *)args);
+  if (argc == 4)
+    {
+    const char *s_lat = klist_get ((KList *)args, 1); 
+    const char *s_lon = klist_get ((KList *)args, 2); 
+    const char *date = klist_get ((KList *)args, 3); 
+
+    klog_debug (KLOG_CLASS, "/coords invoked with lat=%s, long=%s, date=%s", 
+       s_lat, s_lon, date); 
+
+    char *end_lat, *end_lon;
+    double latitude = strtod (s_lat, &end_lat);
+    double longitude = strtod (s_lon, &end_lon);
+    metrics_timings_mark (timings, METRICS_STAGE_PARSE_URI);
+    if (*s_lat && *end_lat == 0 && *s_lon && *end_lon == 0 
+        && latitude >= -90 && latitude <= 90 
+        && longitude >= -180 && longitude <= 180)
+      {
+      time_t t_date = datetimeconv_parse_date (date, 2, 0, NULL);
+      metrics_timings_mark (timings, METRICS_STAGE_PARSE_DATE);
+      if (t_date)
+        {
+        // Nobody will notice the difference between locations closer
+        //  than about ten metres, so round them for the cache. The 
+        //  summary is worked out, and reports, the rounded location,
+        //  so that a cached body is right for every caller with the
+        //  same key
+        latitude = round (latitude * 10000.0) / 10000.0;
+        longitude = round (longitude * 10000.0) / 10000.0;
+        const SolCity *c = solcity_find_nearest (latitude, longitude);
+        metrics_timings_mark (timings, METRICS_STAGE_FIND_CITY);
+        const char *full_city = solcity_get_name (c);
+        char key[128];
+        snprintf (key, sizeof (key), "@%.4f,%.4f/%ld", latitude, 
+          longitude, (long)t_date);
+        *response = request_handler_day_summary (self, key, t_date,
+          latitude, longitude, full_city, solcity_get_zone (c), timings);
+        *code = 200;
+        }
+      else
+        {
+        *response = response_body_new_from_string (RESPONSE_BODY_TEXT, 
+          "Could not parse date\n");
+        *code = 400;
+        }
       }
     else
       {
-      asprintf (response, "Could not parse date\n");
+      *response = response_body_new_from_string (RESPONSE_BODY_TEXT, 
+        "Could not parse coordinates\n");
       *code = 400;
       }
     }
   else
     {
-    asprintf (response, "/day API takes two arguments -- city and date\n");
+    *response = response_body_new_from_string (RESPONSE_BODY_TEXT, 
+      "/coords API takes three arguments -- latitude, longitude, and date\n");
     *code = 400;
     }
   KLOG_OUT
@@ -172,26 +790,78 @@ void request_handler_day (const RequestHandler *self, const KList *args,
 
 ============================================================================*/
 void request_handler_health (const RequestHandler *self, const KList *args, 
-    char **response, int *code) 
+    const KBuffer *upload, ResponseBody **response, 
+    ResponseStream **stream, int *code, MetricsTimings *timings) 
   {
-  asprintf (response, "{\"health\": \"OK\"}\n");
+  // The body never changes, so it is built once, and shared
+  *response = response_body_ref (self->health_body);
   *code = 200;
   }
 
 
+/*============================================================================
+
+  request_handler_write_cache_metrics
+
+  Write the counters of one of the response caches, in Prometheus 
+  text format, as metrics whose names start with prefix. title and
+  noun describe the cache, at the start of a sentence and elsewhere
+
+============================================================================*/
+static void request_handler_write_cache_metrics (FILE *f, 
+       const char *prefix, const char *title, const char *noun, 
+       ResponseCache *cache)
+  {
+  long hits, misses, evictions;
+  int entries;
+  response_cache_get_stats (cache, &hits, &misses, &evictions, &entries);
+  fprintf (f, "# HELP %s_hits_total %s hits.\n", prefix, title);
+  fprintf (f, "# TYPE %s_hits_total counter\n", prefix);
+  fprintf (f, "%s_hits_total %ld\n", prefix, hits);
+  fprintf (f, "# HELP %s_misses_total %s misses.\n", prefix, title);
+  fprintf (f, "# TYPE %s_misses_total counter\n", prefix);
+  fprintf (f, "%s_misses_total %ld\n", prefix, misses);
+  fprintf (f, "# HELP %s_evictions_total "
+    "Responses evicted from the %s.\n", prefix, noun);
+  fprintf (f, "# TYPE %s_evictions_total counter\n", prefix);
+  fprintf (f, "%s_evictions_total %ld\n", prefix, evictions);
+  fprintf (f, "# HELP %s_entries Responses in the %s.\n", prefix, 
+    noun);
+  fprintf (f, "# TYPE %s_entries gauge\n", prefix);
+  fprintf (f, "%s_entries %d\n", prefix, entries);
+  }
+
 /*============================================================================
 
   request_handler_metrics
 
-  Genarate a request for the /metrics API
+  Genarate a request for the /metrics API, in Prometheus text format
 
 ============================================================================*/
 
 void request_handler_metrics (const RequestHandler *self, const KList *args, 
-    char **response, int *code)
+    const KBuffer *upload, ResponseBody **response, 
+    ResponseStream **stream, int *code, MetricsTimings *timings)
   {
-  asprintf (response, "{\"requests\": %d,\"requests_ok\": %d,\"requests_error\": %d}\n", 
-    self->requests, self->ok_requests, self->requests - self->ok_requests);
+  char *buff = NULL;
+  size_t size = 0;
+  FILE *f = open_memstream (&buff, &size);
+
+  metrics_write (self->metrics, f);
+
+  request_handler_write_cache_metrics (f, "solunar_cache", 
+    "Response cache", "cache", self->day_cache);
+  request_handler_write_cache_metrics (f, "solunar_year_cache", 
+    "/year response cache", "/year cache", self->year_cache);
+  fprintf (f, "# HELP solunar_log_dropped_total "
+    "Log messages dropped by the asynchronous logger.\n");
+  fprintf (f, "# TYPE solunar_log_dropped_total counter\n");
+  fprintf (f, "solunar_log_dropped_total %llu\n", 
+    (unsigned long long)kasynclog_get_dropped ());
+
+  fclose (f);
+  *response = response_body_new (METRICS_CONTENT_TYPE, buff, size);
+  free (buff);
   *code = 200;
   }
 
@@ -201,11 +871,19 @@ void request_handler_metrics (const RequestHandler *self, const KList *args,
   request_handler_api
 
 ============================================================================*/
-void request_handler_api (RequestHandler *self, const char *_uri, 
-       const KProps* arguments, int *code, char **page)
+void request_handler_api (RequestHandler *self, const char *method,
+       const char *_uri, const KProps* arguments, const KBuffer *upload, 
+       int *code, ResponseBody **page, ResponseStream **stream, 
+       char **server_timing)
   {
   KLOG_IN
+  *page = NULL;
+  *stream = NULL;
+  MetricsTimings timings;
+  metrics_timings_init (&timings);
+  uint64_t start = timings.mark;
   klog_debug (KLOG_CLASS, "API request: %s", _uri);
+  int endpoint = self->nendpoints - 1;
 
   char *uri = strdup (_uri);
   KList *args = klist_new_empty (free);
@@ -216,6 +894,7 @@ void request_handler_api (RequestHandler *self, const char *_uri,
     klist_append (args, strdup (arg));
     arg = strtok_r (NULL, "/", &sp);
     }
+  metrics_timings_mark (&timings, METRICS_STAGE_PARSE_URI);
 
   int argc = klist_length (args);
   if (argc > 0)
@@ -228,7 +907,16 @@ void request_handler_api (RequestHandler *self, const char *_uri,
       const char *arg0 = klist_get (args, 0);
       if (strcmp (arg0, ah->name) == 0)
         {
-        ah->fn (self, args, page, code); 
+        BOOL post = method && strcmp (method, "POST") == 0;
+        if (post == ah->post)
+          ah->fn (self, args, upload, page, stream, code, &timings); 
+        else
+          {
+          *page = response_body_new_from_string (RESPONSE_BODY_TEXT, 
+            "Method not allowed\n");
+          *code = 405;
+          }
+        endpoint = i;
         done = TRUE;
         }
       i++;
@@ -237,25 +925,53 @@ void request_handler_api (RequestHandler *self, const char *_uri,
     if (!done)
       {
       // Error no match
-      asprintf (page, "Not found\n");
+      *page = response_body_new_from_string (RESPONSE_BODY_TEXT, 
+        "Not found\n");
       *code = 404;
       }
     }
   else
     {
     // Error no args
-    asprintf (page, "Not found\n");
+    *page = response_body_new_from_string (RESPONSE_BODY_TEXT, 
+      "Not found\n");
     *code = 404;
     }
 
   KLOG_OUT
 
   klist_destroy (args);
-  if (*code == 200)
-    self->ok_requests++;
-  self->requests++;
-
   free (uri);
+
+  // A stream is counted when it has been sent
+  if (*page)
+    metrics_record_request (self->metrics, endpoint, *code, 
+      metrics_now () - start, response_body_get_size (*page));
+  metrics_record_timings (self->metrics, endpoint, &timings);
+
+  if (server_timing)
+    {
+    *server_timing = NULL;
+    if (arguments && kprops_get_utf8 (arguments, (UTF8 *)"debug"))
+      {
+      char s[256];
+      metrics_timings_to_server_timing (&timings, s, sizeof (s));
+      *server_timing = strdup (s);
+      }
+    }
+  }
+
+/*============================================================================
+
+  request_handler_notify_connection
+
+============================================================================*/
+void request_handler_notify_connection (RequestHandler *self, BOOL opened)
+  {
+  if (opened)
+    metrics_connection_opened (self->metrics);
+  else
+    metrics_connection_closed (self->metrics);
   }
 
 /*============================================================================
@@ -10,6 +10,15 @@
 
 #include <klib/klib.h> 
 #include "program_context.h"
+#include "response_body.h"
+#include "response_stream.h"
+
+/** The number of /day responses cached, if --cache-size is not given. */
+#define REQUEST_HANDLER_DEFAULT_CACHE_SIZE 4096
+
+/** The number of /year responses cached. Each is for a year, a zone,
+    and a hemisphere, so this covers every zone for a few years. */
+#define REQUEST_HANDLER_YEAR_CACHE_SIZE 2048
 
 struct _RequestHandler;
 typedef struct _RequestHandler RequestHandler;
@@ -20,8 +29,23 @@ RequestHandler *request_handler_create (const ProgramContext *content);
 
 void            request_handler_destroy (RequestHandler *self);
 
-void request_handler_api (RequestHandler *self, const char *uri, 
-      const KProps *arguments, int *code, char **buff);
+/** Handle an API request. upload is the body of a POST request, or
+    NULL. The response body is written to body, with
+    a reference that belongs to the caller -- or, for a response that
+    is produced as it is sent, body is set to NULL, and a stream, 
+    which the caller must destroy, is written to stream. If 
+    server_timing is not NULL, and the request has a "debug" argument, 
+    it is set to the value for a Server-Timing header, giving the time 
+    taken by each stage of the request, which the caller must free; 
+    otherwise it is set to NULL. */
+void request_handler_api (RequestHandler *self, const char *method,
+      const char *uri, const KProps *arguments, const KBuffer *upload, 
+      int *code, ResponseBody **body, ResponseStream **stream, 
+      char **server_timing);
+
+/** Tell the handler that a client connection has been opened or
+    closed, so that it can report the number that are open. */
+void request_handler_notify_connection (RequestHandler *self, BOOL opened);
 
 BOOL request_handler_shutdown_requested (const RequestHandler *self);
 
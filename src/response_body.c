@@ -0,0 +1,179 @@
+/*============================================================================
+  
+  solunar_ws 
+  
+  response_body.c
+
+  Copyright (c)1990-2020 Kevin Boone. Distributed under the terms of the
+  GNU Public Licence, v3.0
+
+  ==========================================================================*/
+#define  _GNU_SOURCE
+#include <assert.h> 
+#include <stdio.h> 
+#include <stdlib.h> 
+#include <stdarg.h> 
+#include <string.h> 
+#include <klib/klib.h> 
+#include "response_body.h" 
+
+#define KLOG_CLASS "solunar_ws.response_body"
+
+/*============================================================================
+  
+  ResponseBody  
+
+  ==========================================================================*/
+struct _ResponseBody
+  {
+  int refs; // Only changed atomically
+  const char *content_type;
+  size_t size;
+  char data[]; // size bytes, and a terminating nul
+  };
+
+/*============================================================================
+  
+  response_body_new
+
+  ==========================================================================*/
+ResponseBody *response_body_new (const char *content_type, 
+       const char *data, size_t size)
+  {
+  KLOG_IN
+  ResponseBody *self = malloc (sizeof (ResponseBody) + size + 1);
+  self->refs = 1;
+  self->content_type = content_type;
+  self->size = size;
+  memcpy (self->data, data, size);
+  self->data[size] = 0;
+  KLOG_OUT
+  return self;
+  }
+
+/*============================================================================
+  
+  response_body_new_from_string
+
+  ==========================================================================*/
+ResponseBody *response_body_new_from_string (const char *content_type, 
+       const char *s)
+  {
+  KLOG_IN
+  ResponseBody *self = response_body_new (content_type, s, strlen (s));
+  KLOG_OUT
+  return self;
+  }
+
+/*============================================================================
+  
+  response_body_new_printf
+
+  ==========================================================================*/
+ResponseBody *response_body_new_printf (const char *content_type, 
+       const char *fmt, ...)
+  {
+  KLOG_IN
+  va_list ap;
+  va_start (ap, fmt);
+  char *s = NULL;
+  int size = vasprintf (&s, fmt, ap);
+  va_end (ap);
+  ResponseBody *self;
+  if (size >= 0)
+    {
+    self = response_body_new (content_type, s, size);
+    free (s);
+    }
+  else
+    self = response_body_new (content_type, "", 0);
+  KLOG_OUT
+  return self;
+  }
+
+/*============================================================================
+  
+  response_body_ref
+
+  ==========================================================================*/
+ResponseBody *response_body_ref (ResponseBody *self)
+  {
+  KLOG_IN
+  assert (self != NULL);
+  __atomic_add_fetch (&self->refs, 1, __ATOMIC_RELAXED);
+  KLOG_OUT
+  return self;
+  }
+
+/*============================================================================
+  
+  response_body_unref
+
+  ==========================================================================*/
+void response_body_unref (ResponseBody *self)
+  {
+  KLOG_IN
+  if (self)
+    {
+    if (__atomic_sub_fetch (&self->refs, 1, __ATOMIC_ACQ_REL) == 0)
+      free (self);
+    }
+  KLOG_OUT
+  }
+
+/*============================================================================
+  
+  response_body_unref_data
+
+  ==========================================================================*/
+void response_body_unref_data (void *data)
+  {
+  KLOG_IN
+  if (data)
+    {
+    ResponseBody *self = (ResponseBody *)
+      ((char *)data - offsetof (ResponseBody, data));
+    response_body_unref (self);
+    }
+  KLOG_OUT
+  }
+
+/*============================================================================
+  
+  response_body_get_data
+
+  ==========================================================================*/
+const char *response_body_get_data (const ResponseBody *self)
+  {
+  KLOG_IN
+  const char *ret = self->data;
+  KLOG_OUT
+  return ret;
+  }
+
+/*============================================================================
+  
+  response_body_get_size
+
+  ==========================================================================*/
+size_t response_body_get_size (const ResponseBody *self)
+  {
+  KLOG_IN
+  size_t ret = self->size;
+  KLOG_OUT
+  return ret;
+  }
+
+/*============================================================================
+  
+  response_body_get_content_type
+
+  ==========================================================================*/
+const char *response_body_get_content_type (const ResponseBody *self)
+  {
+  KLOG_IN
+  const char *ret = self->content_type;
+  KLOG_OUT
+  return ret;
+  }
+
@@ -0,0 +1,71 @@
+/*============================================================================
+  
+  solunar_ws 
+  
+  response_body.h
+
+  An immutable, reference-counted response body. A body is built once,
+  and can then be shared by the response cache and by any number of
+  responses in flight at the same time; it is freed when the last 
+  reference is released. The data is stored in the same block as the
+  reference count, so a body can be handed to microhttpd without 
+  copying, and recovered from the data pointer that microhttpd passes
+  back to its free callback.
+
+  Copyright (c)1990-2020 Kevin Boone. Distributed under the terms of the
+  GNU Public Licence, v3.0
+
+  ==========================================================================*/
+
+#pragma once
+
+#include <stddef.h>
+#include <klib/klib.h>
+
+#define RESPONSE_BODY_JSON "application/json; charset=utf8"
+#define RESPONSE_BODY_TEXT "text/plain; charset=utf8"
+// Newline-delimited JSON: one JSON value on each line
+#define RESPONSE_BODY_NDJSON "application/x-ndjson; charset=utf8"
+
+struct _ResponseBody;
+typedef struct _ResponseBody ResponseBody;
+
+BEGIN_DECLS
+
+/** Create a body holding a copy of size bytes of data. content_type
+    is not copied, and must be a string constant, like 
+    RESPONSE_BODY_JSON. The new body has one reference, which belongs
+    to the caller. */
+extern ResponseBody *response_body_new (const char *content_type, 
+                       const char *data, size_t size);
+
+/** As response_body_new, for a nul-terminated string. */
+extern ResponseBody *response_body_new_from_string 
+                       (const char *content_type, const char *s);
+
+/** As response_body_new_from_string, with printf-style formatting. */
+extern ResponseBody *response_body_new_printf (const char *content_type, 
+                       const char *fmt, ...);
+
+/** Add a reference. Returns self, for convenience. */
+extern ResponseBody *response_body_ref (ResponseBody *self);
+
+/** Release a reference, freeing the body if it was the last. */
+extern void          response_body_unref (ResponseBody *self);
+
+/** Release a reference, given the data pointer of the body rather 
+    than the body itself. This has the signature of a microhttpd 
+    free callback. */
+extern void          response_body_unref_data (void *data);
+
+/** The data is nul-terminated, although the terminator is not counted
+    in the size. */
+extern const char   *response_body_get_data (const ResponseBody *self);
+
+extern size_t        response_body_get_size (const ResponseBody *self);
+
+extern const char   *response_body_get_content_type 
+                       (const ResponseBody *self);
+
+END_DECLS
+
@@ -0,0 +1,345 @@
+/*============================================================================
+  
+  solunar_ws 
+  
+  response_cache.c
+
+  Each shard is a chained hash table, whose entries are also linked into
+  a list in order of use, most recent first. The shard for a key is 
+  chosen from the top bits of its hash, and the bucket from the bottom
+  bits, so the two choices are independent.
+
+  Copyright (c)1990-2020 Kevin Boone. Distributed under the terms of the
+  GNU Public Licence, v3.0
+
+  ==========================================================================*/
+#include <assert.h> 
+#include <stdio.h> 
+#include <stdlib.h> 
+#include <stdint.h> 
+#include <string.h> 
+#include <pthread.h> 
+#include <klib/klib.h> 
+#include "response_body.h" 
+#include "response_cache.h" 
+
+#define KLOG_CLASS "solunar_ws.response_cache"
+
+#define NUM_SHARDS 16
+
+/*============================================================================
+  
+  CacheEntry
+
+  ==========================================================================*/
+typedef struct _CacheEntry
+  {
+  char *key;
+  ResponseBody *value;
+  uint32_t hash;
+  struct _CacheEntry *chain; // Next in hash bucket
+  struct _CacheEntry *prev;  // More recently used
+  struct _CacheEntry *next;  // Less recently used
+  } CacheEntry;
+
+/*============================================================================
+  
+  CacheShard
+
+  ==========================================================================*/
+typedef struct _CacheShard
+  {
+  pthread_mutex_t lock;
+  CacheEntry **buckets;
+  int nbuckets; // A power of two
+  int entries;
+  int capacity;
+  CacheEntry *head; // Most recently used
+  CacheEntry *tail; // Least recently used
+  long hits;
+  long misses;
+  long evictions;
+  } CacheShard;
+
+/*============================================================================
+  
+  ResponseCache  
+
+  ==========================================================================*/
+struct _ResponseCache
+  {
+  int capacity;
+  CacheShard shards[NUM_SHARDS];
+  };
+
+/*============================================================================
+  
+  response_cache_hash
+
+  FNV-1a, followed by a final mix, because the top bits of plain FNV
+  are poorly distributed for short keys that differ only at the end --
+  which ours do.
+
+  ==========================================================================*/
+static uint32_t response_cache_hash (const char *s)
+  {
+  uint32_t h = 2166136261u;
+  while (*s)
+    {
+    h ^= (unsigned char)*s++;
+    h *= 16777619u;
+    }
+  h ^= h >> 16;
+  h *= 0x85ebca6bu;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35u;
+  h ^= h >> 16;
+  return h;
+  }
+
+/*============================================================================
+  
+  response_cache_new
+
+  ==========================================================================*/
+ResponseCache *response_cache_new (int capacity)
+  {
+  KLOG_IN
+  ResponseCache *self = malloc (sizeof (ResponseCache));
+  memset (self, 0, sizeof (ResponseCache));
+  if (capacity < 0) capacity = 0;
+  self->capacity = capacity;
+  int per_shard = (capacity + NUM_SHARDS - 1) / NUM_SHARDS;
+  int nbuckets = 1;
+  while (nbuckets < per_shard) nbuckets <<= 1;
+  for (int i = 0; i < NUM_SHARDS; i++)
+    {
+    CacheShard *shard = &self->shards[i];
+    pthread_mutex_init (&shard->lock, NULL);
+    shard->capacity = per_shard;
+    shard->nbuckets = nbuckets;
+    shard->buckets = calloc (nbuckets, sizeof (CacheEntry *));
+    }
+  klog_debug (KLOG_CLASS, "Created cache with %d entries per shard", 
+    per_shard);
+  KLOG_OUT
+  return self;
+  }
+
+/*============================================================================
+  
+  response_cache_destroy
+
+  ==========================================================================*/
+void response_cache_destroy (ResponseCache *self)
+  {
+  KLOG_IN
+  if (self)
+    {
+    for (int i = 0; i < NUM_SHARDS; i++)
+      {
+      CacheShard *shard = &self->shards[i];
+      CacheEntry *e = shard->head;
+      while (e)
+        {
+        CacheEntry *next = e->next;
+        free (e->key);
+        response_body_unref (e->value);
+        free (e);
+        e = next;
+        }
+      free (shard->buckets);
+      pthread_mutex_destroy (&shard->lock);
+      }
+    free (self);
+    }
+  KLOG_OUT
+  }
+
+/*============================================================================
+  
+  response_cache_shard
+
+  ==========================================================================*/
+static CacheShard *response_cache_shard (ResponseCache *self, uint32_t hash)
+  {
+  return &self->shards[hash >> 28];
+  }
+
+/*============================================================================
+  
+  response_cache_find
+
+  The shard must be locked
+
+  ==========================================================================*/
+static CacheEntry *response_cache_find (CacheShard *shard, uint32_t hash,
+         const char *key)
+  {
+  CacheEntry *e = shard->buckets[hash & (shard->nbuckets - 1)];
+  while (e)
+    {
+    if (e->hash == hash && strcmp (e->key, key) == 0) return e;
+    e = e->chain;
+    }
+  return NULL;
+  }
+
+/*============================================================================
+  
+  response_cache_unlink
+
+  Remove an entry from the use list. The shard must be locked
+
+  ==========================================================================*/
+static void response_cache_unlink (CacheShard *shard, CacheEntry *e)
+  {
+  if (e->prev) e->prev->next = e->next; else shard->head = e->next;
+  if (e->next) e->next->prev = e->prev; else shard->tail = e->prev;
+  e->prev = NULL;
+  e->next = NULL;
+  }
+
+/*============================================================================
+  
+  response_cache_push_front
+
+  Make an entry the most recently used. The shard must be locked
+
+  ==========================================================================*/
+static void response_cache_push_front (CacheShard *shard, CacheEntry *e)
+  {
+  e->prev = NULL;
+  e->next = shard->head;
+  if (shard->head) shard->head->prev = e; else shard->tail = e;
+  shard->head = e;
+  }
+
+/*============================================================================
+  
+  response_cache_evict
+
+  Remove the least recently used entry. The shard must be locked
+
+  ==========================================================================*/
+static void response_cache_evict (CacheShard *shard)
+  {
+  CacheEntry *e = shard->tail;
+  if (!e) return;
+  response_cache_unlink (shard, e);
+  CacheEntry **p = &shard->buckets[e->hash & (shard->nbuckets - 1)];
+  while (*p != e) p = &(*p)->chain;
+  *p = e->chain;
+  free (e->key);
+  response_body_unref (e->value);
+  free (e);
+  shard->entries--;
+  shard->evictions++;
+  }
+
+/*============================================================================
+  
+  response_cache_get
+
+  ==========================================================================*/
+ResponseBody *response_cache_get (ResponseCache *self, const char *key)
+  {
+  KLOG_IN
+  assert (self != NULL);
+  assert (key != NULL);
+  ResponseBody *ret = NULL;
+  uint32_t hash = response_cache_hash (key);
+  CacheShard *shard = response_cache_shard (self, hash);
+  pthread_mutex_lock (&shard->lock);
+  CacheEntry *e = response_cache_find (shard, hash, key);
+  if (e)
+    {
+    if (shard->head != e)
+      {
+      response_cache_unlink (shard, e);
+      response_cache_push_front (shard, e);
+      }
+    ret = response_body_ref (e->value);
+    shard->hits++;
+    }
+  else
+    shard->misses++;
+  pthread_mutex_unlock (&shard->lock);
+  KLOG_OUT
+  return ret;
+  }
+
+/*============================================================================
+  
+  response_cache_put
+
+  ==========================================================================*/
+void response_cache_put (ResponseCache *self, const char *key, 
+       ResponseBody *value)
+  {
+  KLOG_IN
+  assert (self != NULL);
+  assert (key != NULL);
+  assert (value != NULL);
+  uint32_t hash = response_cache_hash (key);
+  CacheShard *shard = response_cache_shard (self, hash);
+  if (shard->capacity > 0)
+    {
+    ResponseBody *new_value = response_body_ref (value);
+    ResponseBody *old_value = NULL;
+    pthread_mutex_lock (&shard->lock);
+    CacheEntry *e = response_cache_find (shard, hash, key);
+    if (e)
+      {
+      old_value = e->value;
+      e->value = new_value;
+      response_cache_unlink (shard, e);
+      }
+    else
+      {
+      if (shard->entries >= shard->capacity) 
+        response_cache_evict (shard);
+      e = malloc (sizeof (CacheEntry));
+      e->key = strdup (key);
+      e->value = new_value;
+      e->hash = hash;
+      int b = hash & (shard->nbuckets - 1);
+      e->chain = shard->buckets[b];
+      shard->buckets[b] = e;
+      shard->entries++;
+      }
+    response_cache_push_front (shard, e);
+    pthread_mutex_unlock (&shard->lock);
+    response_body_unref (old_value);
+    }
+  KLOG_OUT
+  }
+
+/*============================================================================
+  
+  response_cache_get_stats
+
+  ==========================================================================*/
+void response_cache_get_stats (ResponseCache *self, long *hits, 
+       long *misses, long *evictions, int *entries)
+  {
+  KLOG_IN
+  long h = 0, m = 0, ev = 0;
+  int n = 0;
+  for (int i = 0; i < NUM_SHARDS; i++)
+    {
+    CacheShard *shard = &self->shards[i];
+    pthread_mutex_lock (&shard->lock);
+    h += shard->hits;
+    m += shard->misses;
+    ev += shard->evictions;
+    n += shard->entries;
+    pthread_mutex_unlock (&shard->lock);
+    }
+  if (hits) *hits = h;
+  if (misses) *misses = m;
+  if (evictions) *evictions = ev;
+  if (entries) *entries = n;
+  KLOG_OUT
+  }
+
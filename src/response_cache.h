@@ -0,0 +1,54 @@
+/*============================================================================
+  
+  solunar_ws 
+  
+  response_cache.h
+
+  A bounded, thread-safe cache of finished response bodies, keyed by
+  strings. The cache holds a reference to each body it stores, so a 
+  body that is evicted while it is still being sent stays alive until
+  the send completes. The cache is divided into shards, each with its own lock and
+  its own least-recently-used list, so that threads looking up 
+  different keys rarely contend.
+
+  Copyright (c)1990-2020 Kevin Boone. Distributed under the terms of the
+  GNU Public Licence, v3.0
+
+  ==========================================================================*/
+
+#pragma once
+
+#include <klib/klib.h>
+#include "response_body.h"
+
+struct _ResponseCache;
+typedef struct _ResponseCache ResponseCache;
+
+BEGIN_DECLS
+
+/** Create a cache that holds at most (roughly) capacity entries. The 
+    capacity is divided evenly between the shards. A capacity of zero
+    gives a cache that stores nothing, and always misses. */
+extern ResponseCache *response_cache_new (int capacity);
+
+extern void      response_cache_destroy (ResponseCache *self);
+
+/** Look up a key. If it is present, returns a new reference to the 
+    body, which the caller must release, and marks the entry as 
+    recently used. Otherwise returns NULL. */
+extern ResponseBody *response_cache_get (ResponseCache *self, 
+                   const char *key);
+
+/** Store a reference to the body under a copy of the key, replacing any
+    body already stored, and evicting the least-recently used entry 
+    in the shard if it is full. The caller keeps its own reference. */
+extern void      response_cache_put (ResponseCache *self, const char *key, 
+                   ResponseBody *value);
+
+/** Get the counters, totalled over all shards. Any of the arguments can
+    be NULL. */
+extern void      response_cache_get_stats (ResponseCache *self, 
+                   long *hits, long *misses, long *evictions, int *entries);
+
+END_DECLS
+
@@ -0,0 +1,91 @@
+/*============================================================================
+  
+  solunar_ws 
+  
+  response_stream.c
+
+  Copyright (c)1990-2020 Kevin Boone. Distributed under the terms of the
+  GNU Public Licence, v3.0
+
+  ==========================================================================*/
+#include <stdio.h> 
+#include <stdlib.h> 
+#include <klib/klib.h> 
+#include "response_stream.h" 
+
+#define KLOG_CLASS "solunar_ws.response_stream"
+
+/*============================================================================
+  
+  ResponseStream  
+
+  ==========================================================================*/
+struct _ResponseStream
+  {
+  const char *content_type;
+  ResponseStreamReadFn read_fn;
+  ResponseStreamFreeFn free_fn;
+  void *user_data;
+  };
+
+/*============================================================================
+  
+  response_stream_new
+
+  ==========================================================================*/
+ResponseStream *response_stream_new (const char *content_type,
+       ResponseStreamReadFn read_fn, ResponseStreamFreeFn free_fn, 
+       void *user_data)
+  {
+  KLOG_IN
+  ResponseStream *self = malloc (sizeof (ResponseStream));
+  self->content_type = content_type;
+  self->read_fn = read_fn;
+  self->free_fn = free_fn;
+  self->user_data = user_data;
+  KLOG_OUT
+  return self;
+  }
+
+/*============================================================================
+  
+  response_stream_destroy
+
+  ==========================================================================*/
+void response_stream_destroy (ResponseStream *self)
+  {
+  KLOG_IN
+  if (self)
+    {
+    if (self->free_fn) self->free_fn (self->user_data);
+    free (self);
+    }
+  KLOG_OUT
+  }
+
+/*============================================================================
+  
+  response_stream_read
+
+  ==========================================================================*/
+ssize_t response_stream_read (ResponseStream *self, char *buff, size_t max)
+  {
+  KLOG_IN
+  ssize_t ret = self->read_fn (self->user_data, buff, max);
+  KLOG_OUT
+  return ret;
+  }
+
+/*============================================================================
+  
+  response_stream_get_content_type
+
+  ==========================================================================*/
+const char *response_stream_get_content_type (const ResponseStream *self)
+  {
+  KLOG_IN
+  const char *ret = self->content_type;
+  KLOG_OUT
+  return ret;
+  }
+
@@ -0,0 +1,58 @@
+/*============================================================================
+  
+  solunar_ws 
+  
+  response_stream.h
+
+  A response body that is produced a piece at a time, as the client 
+  reads it, rather than built in full before it is sent. It is used 
+  for responses that can be arbitrarily long, so that the memory a 
+  response needs does not depend on its length. The producer is a 
+  pair of functions supplied by the creator: one to fill a buffer with 
+  the next piece of the body, and one to release the producer's state 
+  when the response is finished with -- whether or not it was sent
+  in full. 
+
+  Copyright (c)1990-2020 Kevin Boone. Distributed under the terms of the
+  GNU Public Licence, v3.0
+
+  ==========================================================================*/
+
+#pragma once
+
+#include <stddef.h>
+#include <sys/types.h>
+#include <klib/klib.h>
+
+/** Fill buff with up to max bytes of the body. Returns the number of
+    bytes written, which must be greater than zero, or -1 at the end of 
+    the body. */
+typedef ssize_t (*ResponseStreamReadFn) (void *user_data, char *buff, 
+                   size_t max);
+
+/** Release the producer's state. */
+typedef void (*ResponseStreamFreeFn) (void *user_data);
+
+struct _ResponseStream;
+typedef struct _ResponseStream ResponseStream;
+
+BEGIN_DECLS
+
+/** Create a stream. content_type is not copied, and must be a string
+    constant, like RESPONSE_BODY_JSON. free_fn, which may be NULL, is 
+    called with user_data when the stream is destroyed. */
+extern ResponseStream *response_stream_new (const char *content_type,
+                         ResponseStreamReadFn read_fn, 
+                         ResponseStreamFreeFn free_fn, void *user_data);
+
+extern void            response_stream_destroy (ResponseStream *self);
+
+/** Get the next piece of the body, as ResponseStreamReadFn. */
+extern ssize_t         response_stream_read (ResponseStream *self, 
+                         char *buff, size_t max);
+
+extern const char     *response_stream_get_content_type 
+                         (const ResponseStream *self);
+
+END_DECLS
+
@@ -0,0 +1,223 @@
+/*============================================================================
+  
+  solunar_ws 
+  
+  work_pool.c
+
+  Each call to work_pool_run() creates a task on its own stack, and 
+  puts it on the pool's list of tasks. Threads -- the pool's and the
+  submitter -- claim items from a task by atomically incrementing its
+  next-item counter, so items are handed out without locking. The pool
+  lock is taken only to find a task, and to report that a thread has
+  finished with it. The submitter waits until every item is done and
+  no pool thread is still looking at the task, before the task goes
+  out of scope.
+
+  Copyright (c)1990-2020 Kevin Boone. Distributed under the terms of the
+  GNU Public Licence, v3.0
+
+  ==========================================================================*/
+#include <stdio.h> 
+#include <stdlib.h> 
+#include <string.h> 
+#include <pthread.h> 
+#include <klib/klib.h> 
+#include "work_pool.h" 
+
+#define KLOG_CLASS "solunar_ws.work_pool"
+
+/*============================================================================
+  
+  WorkPoolTask 
+
+  ==========================================================================*/
+typedef struct _WorkPoolTask
+  {
+  struct _WorkPoolTask *next_task;
+  int n;
+  int next;      // Next item to claim; updated atomically
+  int done;      // Items finished; protected by the pool lock
+  int active;    // Pool threads working on this task; ditto
+  WorkPoolFn fn;
+  void *user_data;
+  } WorkPoolTask;
+
+/*============================================================================
+  
+  WorkPool 
+
+  ==========================================================================*/
+struct _WorkPool
+  {
+  pthread_mutex_t lock;
+  pthread_cond_t work_cond;  // Signalled when a task is added
+  pthread_cond_t done_cond;  // Signalled when a thread leaves a task
+  WorkPoolTask *tasks;
+  BOOL stop;
+  int nthreads;
+  pthread_t *threads;
+  };
+
+/*============================================================================
+  
+  work_pool_remove_task
+
+  Take a task off the list, if it is still there. Call with the lock
+  held.
+
+  ==========================================================================*/
+static void work_pool_remove_task (WorkPool *self, WorkPoolTask *task)
+  {
+  WorkPoolTask **p = &self->tasks;
+  while (*p && *p != task) p = &(*p)->next_task;
+  if (*p) *p = task->next_task;
+  }
+
+/*============================================================================
+  
+  work_pool_do_items
+
+  Claim and do items from the task until there are none left. Returns
+  the number done.
+
+  ==========================================================================*/
+static int work_pool_do_items (WorkPoolTask *task)
+  {
+  int count = 0;
+  int i;
+  while ((i = __atomic_fetch_add (&task->next, 1, __ATOMIC_RELAXED)) 
+         < task->n)
+    {
+    task->fn (i, task->user_data);
+    count++;
+    }
+  return count;
+  }
+
+/*============================================================================
+  
+  work_pool_thread
+
+  ==========================================================================*/
+static void *work_pool_thread (void *arg)
+  {
+  WorkPool *self = arg;
+  pthread_mutex_lock (&self->lock);
+  while (!self->stop)
+    {
+    WorkPoolTask *task = self->tasks;
+    if (!task)
+      {
+      pthread_cond_wait (&self->work_cond, &self->lock);
+      continue;
+      }
+    task->active++;
+    pthread_mutex_unlock (&self->lock);
+
+    int count = work_pool_do_items (task);
+
+    pthread_mutex_lock (&self->lock);
+    // All the items have been claimed, so nobody else needs to find 
+    //  this task
+    work_pool_remove_task (self, task);
+    task->done += count;
+    task->active--;
+    pthread_cond_broadcast (&self->done_cond);
+    }
+  pthread_mutex_unlock (&self->lock);
+  return NULL;
+  }
+
+/*============================================================================
+  
+  work_pool_new
+
+  ==========================================================================*/
+WorkPool *work_pool_new (int threads)
+  {
+  KLOG_IN
+  WorkPool *self = malloc (sizeof (WorkPool));
+  memset (self, 0, sizeof (WorkPool));
+  pthread_mutex_init (&self->lock, NULL);
+  pthread_cond_init (&self->work_cond, NULL);
+  pthread_cond_init (&self->done_cond, NULL);
+  self->threads = malloc ((threads > 0 ? threads : 1) * sizeof (pthread_t));
+  for (int i = 0; i < threads; i++)
+    {
+    if (pthread_create (&self->threads[i], NULL, work_pool_thread, self) 
+          != 0)
+      {
+      klog_warn (KLOG_CLASS, "Can't start work pool thread");
+      break;
+      }
+    self->nthreads++;
+    }
+  KLOG_OUT
+  return self;
+  }
+
+/*============================================================================
+  
+  work_pool_destroy
+
+  ==========================================================================*/
+void work_pool_destroy (WorkPool *self)
+  {
+  KLOG_IN
+  if (self)
+    {
+    pthread_mutex_lock (&self->lock);
+    self->stop = TRUE;
+    pthread_cond_broadcast (&self->work_cond);
+    pthread_mutex_unlock (&self->lock);
+    for (int i = 0; i < self->nthreads; i++)
+      pthread_join (self->threads[i], NULL);
+    pthread_cond_destroy (&self->work_cond);
+    pthread_cond_destroy (&self->done_cond);
+    pthread_mutex_destroy (&self->lock);
+    free (self->threads);
+    free (self);
+    }
+  KLOG_OUT
+  }
+
+/*============================================================================
+  
+  work_pool_run
+
+  ==========================================================================*/
+void work_pool_run (WorkPool *self, int n, WorkPoolFn fn, void *user_data)
+  {
+  KLOG_IN
+  WorkPoolTask task;
+  memset (&task, 0, sizeof (task));
+  task.n = n;
+  task.fn = fn;
+  task.user_data = user_data;
+
+  // With a single item, or no threads, there is nothing to share
+  BOOL share = self->nthreads > 0 && n > 1;
+  if (share)
+    {
+    pthread_mutex_lock (&self->lock);
+    WorkPoolTask **p = &self->tasks;
+    while (*p) p = &(*p)->next_task;
+    *p = &task;
+    pthread_cond_broadcast (&self->work_cond);
+    pthread_mutex_unlock (&self->lock);
+    }
+
+  int count = work_pool_do_items (&task);
+
+  if (share)
+    {
+    pthread_mutex_lock (&self->lock);
+    work_pool_remove_task (self, &task);
+    task.done += count;
+    while (task.done < n || task.active > 0)
+      pthread_cond_wait (&self->done_cond, &self->lock);
+    pthread_mutex_unlock (&self->lock);
+    }
+  KLOG_OUT
+  }
+
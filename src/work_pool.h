@@ -0,0 +1,44 @@
+/*============================================================================
+  
+  solunar_ws 
+  
+  work_pool.h
+
+  A fixed pool of threads for spreading the items of a single request
+  -- a /batch request, for example -- across CPUs. The thread that 
+  submits the work also works on it, rather than waiting idle, so work
+  always makes progress even when every pool thread is busy with 
+  another request's items.
+
+  Copyright (c)1990-2020 Kevin Boone. Distributed under the terms of the
+  GNU Public Licence, v3.0
+
+  ==========================================================================*/
+
+#pragma once
+
+#include <klib/klib.h>
+
+struct _WorkPool;
+typedef struct _WorkPool WorkPool;
+
+/** A function that does item i of some work. */
+typedef void (*WorkPoolFn) (int i, void *user_data);
+
+BEGIN_DECLS
+
+/** Create a pool of the specified number of threads. Zero is allowed,
+    in which case all work is done by the submitting thread. */
+extern WorkPool *work_pool_new (int threads);
+
+/** Stop and join the threads. There must be no work in progress. */
+extern void      work_pool_destroy (WorkPool *self);
+
+/** Call fn for each i from 0 to n - 1, in no particular order and
+    possibly at the same time in different threads. Returns when all the
+    calls have returned. */
+extern void      work_pool_run (WorkPool *self, int n, WorkPoolFn fn, 
+                   void *user_data);
+
+END_DECLS
+